@@ -0,0 +1,281 @@
+// // -----------------------------
+// // projects/deque/BenchDeque.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // -----------------------------
+
+// /*
+// Times the basic operations of my_deque and std::deque side by side,
+// for elements of 4 to 256 bytes and deques of 10 to 10^8 elements.
+// Every row has the time per operation, the allocator calls per operation
+// (both deques take the same counting allocator) and the peak RSS so far.
+
+// To compile the benchmark:
+//     % g++ -O3 -std=c++11 -Wall BenchDeque.c++ -o BenchDeque
+
+// To run the benchmark:
+//     % BenchDeque [--json] [--max n] [--op name]
+// --json writes a JSON array instead of CSV
+// --max  is the largest size to run, default 1000000, at most 100000000
+// --op   runs one operation only: push_back, push_front, pop_back, pop_front,
+//        drain, index, iterate, insert, erase, copy, resize or swap
+
+// To track regressions, keep the output of each release and compare the ns/op columns.
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <algorithm> // min
+#include <chrono>    // steady_clock
+#include <cstddef>   // size_t
+#include <cstdlib>   // strtoul
+#include <cstring>   // memset, strcmp
+#include <deque>     // deque
+#include <iostream>  // cout
+#include <string>    // string
+
+#include <sys/resource.h> // getrusage
+
+#include "Deque.h"
+#include "DequeCountingAllocator.h"
+
+// keeps the optimizer from dropping a result
+volatile long sink;
+
+// -------
+// payload
+// -------
+
+// an element of N bytes
+template <std::size_t N>
+struct payload {
+    char bytes[N];
+
+    payload (int i = 0) {
+        std::memset(bytes, i, N);}
+
+    long value () const {
+        return bytes[0];}};
+
+inline long value (int x) {
+    return x;}
+
+template <std::size_t N>
+long value (const payload<N>& x) {
+    return x.value();}
+
+// ----------
+// operations
+// ----------
+
+// each fills or uses a deque of n elements and returns the number of operations it timed
+
+template <typename D>
+void fill (D& d, std::size_t n) {
+    for (std::size_t i = 0; i != n; ++i)
+        d.push_back(typename D::value_type(int(i)));}
+
+template <typename D>
+std::size_t op_push_back (std::size_t n) {
+    D d;
+    fill(d, n);
+    return n;}
+
+template <typename D>
+std::size_t op_push_front (std::size_t n) {
+    D d;
+    for (std::size_t i = 0; i != n; ++i)
+        d.push_front(typename D::value_type(int(i)));
+    return n;}
+
+template <typename D>
+std::size_t op_pop_back (D& d, std::size_t n) {
+    for (std::size_t i = 0; i != n; ++i)
+        d.pop_back();
+    return n;}
+
+template <typename D>
+std::size_t op_pop_front (D& d, std::size_t n) {
+    for (std::size_t i = 0; i != n; ++i)
+        d.pop_front();
+    return n;}
+
+// empties the deque 64 elements at a time
+template <typename T, typename A>
+std::size_t op_drain (std::deque<T, A>& d, std::size_t n) {
+    while (!d.empty())
+        d.erase(d.begin(), d.begin() + std::min<std::size_t>(d.size(), 64));
+    return n;}
+
+template <typename T, typename A, std::size_t BS>
+std::size_t op_drain (my_deque<T, A, BS>& d, std::size_t n) {
+    while (!d.empty())
+        d.pop_front_n(64);
+    return n;}
+
+template <typename D>
+std::size_t op_index (D& d, std::size_t n) {
+    long          s = 0;
+    unsigned long x = 88172645463325252UL;
+    for (std::size_t i = 0; i != n; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        s += value(d[x % n]);}
+    sink = s;
+    return n;}
+
+template <typename D>
+std::size_t op_iterate (D& d, std::size_t n) {
+    long s = 0;
+    for (typename D::iterator i = d.begin(); i != d.end(); ++i)
+        s += value(*i);
+    sink = s;
+    return n;}
+
+template <typename D>
+std::size_t op_insert (D& d, std::size_t n) {
+    std::size_t k = std::min<std::size_t>(n, 1000);
+    for (std::size_t i = 0; i != k; ++i)
+        d.insert(d.begin() + d.size() / 2, typename D::value_type(int(i)));
+    return k;}
+
+template <typename D>
+std::size_t op_erase (D& d, std::size_t n) {
+    std::size_t k = std::min<std::size_t>(n / 2, 1000);
+    for (std::size_t i = 0; i != k; ++i)
+        d.erase(d.begin() + d.size() / 2);
+    return k;}
+
+template <typename D>
+std::size_t op_copy (D& d, std::size_t n) {
+    D e(d);
+    sink = long(e.size());
+    return n;}
+
+template <typename D>
+std::size_t op_resize (D& d, std::size_t n) {
+    d.resize(2 * n);
+    d.resize(n / 2);
+    return n + n / 2 + n;}
+
+template <typename D>
+std::size_t op_swap (D& d, std::size_t) {
+    D e;
+    for (int i = 0; i != 1000; ++i)
+        d.swap(e);
+    return 1000;}
+
+// ------
+// output
+// ------
+
+bool json  = false;
+bool first = true;
+
+double peak_rss_mib () {
+    rusage u;
+    getrusage(RUSAGE_SELF, &u);
+    return double(u.ru_maxrss) / 1024;}
+
+void row (const char* container, const char* type, std::size_t bytes, std::size_t n, const char* op,
+          double ns, double allocs) {
+    double rss = peak_rss_mib();
+    if (json) {
+        std::cout << (first ? "[\n" : ",\n")
+                  << "  {\"container\": \"" << container << "\", \"type\": \"" << type
+                  << "\", \"bytes\": " << bytes << ", \"n\": " << n << ", \"op\": \"" << op
+                  << "\", \"ns_per_op\": " << ns << ", \"allocs_per_op\": " << allocs
+                  << ", \"peak_rss_mib\": " << rss << "}";}
+    else {
+        if (first)
+            std::cout << "container,type,bytes,n,op,ns/op,allocs/op,peak_rss_mib" << std::endl;
+        std::cout << container << "," << type << "," << bytes << "," << n << "," << op << ","
+                  << ns << "," << allocs << "," << rss << std::endl;}
+    first = false;}
+
+// ------
+// timing
+// ------
+
+const char* only = 0;
+
+// times f, which returns its operation count, over enough repetitions to run a while
+template <typename F>
+void measure (const char* container, const char* type, std::size_t bytes, std::size_t n, const char* op, F f) {
+    if (only && std::strcmp(only, op))
+        return;
+    std::size_t reps = std::max<std::size_t>(1, std::min<std::size_t>(1000, 1000000 / n));
+    std::size_t ops  = 0;
+    double      ns   = 0;
+    counting_allocator_calls() = 0;
+    for (std::size_t r = 0; r != reps; ++r)
+        ns += f(ops);
+    row(container, type, bytes, n, op, ns / ops, double(counting_allocator_calls()) / ops);}
+
+typedef std::chrono::steady_clock clock_type;
+
+double since (clock_type::time_point b) {
+    return std::chrono::duration<double, std::nano>(clock_type::now() - b).count();}
+
+// times f on a deque of n elements, filled beforehand outside the time and the allocation count
+template <typename D, typename F>
+void measure_on (const char* container, const char* type, std::size_t n, const char* op, F f) {
+    measure(container, type, sizeof(typename D::value_type), n, op, [n, f] (std::size_t& ops) {
+        long a = counting_allocator_calls();
+        D    d;
+        fill(d, n);
+        counting_allocator_calls() = a;
+        clock_type::time_point b = clock_type::now();
+        ops += f(d, n);
+        return since(b);});}
+
+// times every operation on deques of n elements
+template <typename D>
+void run (const char* container, const char* type, std::size_t n) {
+    measure(container, type, sizeof(typename D::value_type), n, "push_back", [n] (std::size_t& ops) {
+        clock_type::time_point b = clock_type::now();
+        ops += op_push_back<D>(n);
+        return since(b);});
+    measure(container, type, sizeof(typename D::value_type), n, "push_front", [n] (std::size_t& ops) {
+        clock_type::time_point b = clock_type::now();
+        ops += op_push_front<D>(n);
+        return since(b);});
+    measure_on<D>(container, type, n, "pop_back",  op_pop_back<D>);
+    measure_on<D>(container, type, n, "pop_front", op_pop_front<D>);
+    measure_on<D>(container, type, n, "drain",     [] (D& d, std::size_t n) {return op_drain(d, n);});
+    measure_on<D>(container, type, n, "index",     op_index<D>);
+    measure_on<D>(container, type, n, "iterate",   op_iterate<D>);
+    measure_on<D>(container, type, n, "insert",    op_insert<D>);
+    measure_on<D>(container, type, n, "erase",     op_erase<D>);
+    measure_on<D>(container, type, n, "copy",      op_copy<D>);
+    measure_on<D>(container, type, n, "resize",    op_resize<D>);
+    measure_on<D>(container, type, n, "swap",      op_swap<D>);}
+
+// runs every size for one element type in both deques
+template <typename T>
+void run_type (const char* type, std::size_t most) {
+    // the biggest sizes are only run for small elements, 10^8 256 byte elements would not fit
+    std::size_t cap = std::min<std::size_t>(most, (std::size_t(1) << 31) / sizeof(T));
+    for (std::size_t n = 10; n <= cap; n *= 10) {
+        run< my_deque<T, counting_allocator<T> > >  ("my_deque",   type, n);
+        run< std::deque<T, counting_allocator<T> > >("std::deque", type, n);}}
+
+int main (int argc, char* argv[]) {
+    std::size_t most = 1000000;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--json"))
+            json = true;
+        else if (!std::strcmp(argv[i], "--max") && (i + 1 < argc))
+            most = std::min<std::size_t>(std::strtoul(argv[++i], 0, 10), 100000000);
+        else if (!std::strcmp(argv[i], "--op") && (i + 1 < argc))
+            only = argv[++i];}
+    run_type<int>           ("int",        most);
+    run_type< payload<16> > ("payload16",  most);
+    run_type< payload<64> > ("payload64",  most);
+    run_type< payload<256> >("payload256", most);
+    if (json)
+        std::cout << (first ? "[]" : "\n]") << std::endl;
+    return 0;}
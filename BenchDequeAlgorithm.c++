@@ -0,0 +1,86 @@
+// // --------------------------------------
+// // projects/deque/BenchDequeAlgorithm.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // --------------------------------------
+
+// /*
+// Times the block-wise kernels in DequeAlgorithm.h against the
+// element-wise iterator loop over the same deque and a loop over a vector.
+
+// To compile the benchmark:
+//     % g++ -O3 -std=c++11 -Wall BenchDequeAlgorithm.c++ -o BenchDequeAlgorithm
+
+// To run the benchmark (n elements, default 10000000):
+//     % BenchDequeAlgorithm [n]
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <algorithm> // count, find, min_element
+#include <chrono>    // steady_clock
+#include <cstddef>   // size_t
+#include <cstdlib>   // strtoul
+#include <iostream>  // cout
+#include <vector>    // vector
+
+#include "DequeAlgorithm.h"
+
+// keeps the optimizer from dropping a result
+volatile double sink;
+
+template <typename T>
+void keep (const T& x) {
+    sink = double(x);}
+
+// runs f r times and prints the best time per element
+template <typename F>
+void time_it (const char* name, std::size_t n, F f, int r = 5) {
+    double best = 1e300;
+    for (int i = 0; i < r; ++i) {
+        std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();
+        f();
+        std::chrono::steady_clock::time_point e = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(e - b).count();
+        if (ns < best)
+            best = ns;}
+    std::cout << name << "," << n << "," << best / n << std::endl;}
+
+template <typename T>
+void run (const char* type, std::size_t n) {
+    my_deque<T>    d;
+    std::vector<T> v;
+    for (std::size_t i = 0; i < n; ++i) {
+        d.push_back(T(int((i * 7919) % 1009)));
+        v.push_back(T(int((i * 7919) % 1009)));}
+    const my_deque<T>& c = d;
+
+    std::cout << "# " << type << std::endl;
+    time_it("sum iterator", n, [&] {
+        T s = T();
+        for (typename my_deque<T>::const_iterator i = c.begin(); i != c.end(); ++i)
+            s += *i;
+        keep(s);});
+    time_it("sum vector",   n, [&] {
+        T s = T();
+        for (std::size_t i = 0; i != v.size(); ++i)
+            s += v[i];
+        keep(s);});
+    time_it("sum kernel",   n, [&] {keep(deque_sum(c));});
+    time_it("min iterator", n, [&] {keep(*std::min_element(c.begin(), c.end()));});
+    time_it("min kernel",   n, [&] {keep(deque_min(c));});
+    time_it("max kernel",   n, [&] {keep(deque_max(c));});
+    time_it("count iterator", n, [&] {keep(std::count(c.begin(), c.end(), T(7)));});
+    time_it("count kernel",   n, [&] {keep(deque_count(c, T(7)));});
+    time_it("find iterator",  n, [&] {keep(std::find(c.begin(), c.end(), T(-1)) == c.end());});
+    time_it("find kernel",    n, [&] {keep(deque_find(c, T(-1)) == c.end());});}
+
+int main (int argc, char* argv[]) {
+    std::size_t n = (argc > 1) ? std::strtoul(argv[1], 0, 10) : 10000000;
+    std::cout << "# avx2," << deque_has_avx2() << std::endl;
+    std::cout << "# name,n,ns/element" << std::endl;
+    run<int>("int", n);
+    run<double>("double", n);
+    return 0;}
@@ -0,0 +1,98 @@
+// // --------------------------------------
+// // projects/deque/BenchDequeAllocator.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // --------------------------------------
+
+// /*
+// Times a sequential scan and random at() lookups over a large deque of ints
+// whose blocks come from std::allocator, deque_aligned_allocator or
+// deque_huge_page_allocator (with and without the huge page advice).
+
+// To compile the benchmark:
+//     % g++ -O3 -std=c++11 -Wall BenchDequeAllocator.c++ -o BenchDequeAllocator -lpthread
+
+// To run the benchmark (mode: all, default, aligned, huge or small; n elements, default 268435456):
+//     % BenchDequeAllocator [mode] [n]
+
+// To count TLB misses, run one mode at a time under perf:
+//     % perf stat -e dTLB-loads,dTLB-load-misses,dTLB-stores,dTLB-store-misses BenchDequeAllocator default
+//     % perf stat -e dTLB-loads,dTLB-load-misses,dTLB-stores,dTLB-store-misses BenchDequeAllocator huge
+// "small" uses the same region allocator with the advice off, so it isolates the page size.
+// Whether huge pages were granted shows in the output and in AnonHugePages in /proc/meminfo.
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <chrono>   // steady_clock
+#include <cstddef>  // size_t
+#include <cstdlib>  // strtoul
+#include <cstring>  // strcmp
+#include <iostream> // cout
+#include <memory>   // allocator
+
+#include "Deque.h"
+#include "DequeAllocator.h"
+
+// keeps the optimizer from dropping a result
+volatile long sink;
+
+// runs f r times and prints the best time per operation
+template <typename F>
+void time_it (const char* mode, const char* name, std::size_t n, F f, int r = 3) {
+    double best = 1e300;
+    for (int i = 0; i < r; ++i) {
+        std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();
+        f();
+        std::chrono::steady_clock::time_point e = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(e - b).count();
+        if (ns < best)
+            best = ns;}
+    std::cout << mode << "," << name << "," << n << "," << best / n << std::endl;}
+
+template <typename A>
+void run (const char* mode, std::size_t n, const A& a = A()) {
+    my_deque<int, A> d(a);
+    std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != n; ++i)
+        d.push_back(int(i));
+    std::chrono::steady_clock::time_point e = std::chrono::steady_clock::now();
+    std::cout << mode << ",push_back," << n << "," << std::chrono::duration<double, std::nano>(e - b).count() / n << std::endl;
+    const my_deque<int, A>& c = d;
+
+    time_it(mode, "scan", n, [&] {
+        long s = 0;
+        for (typename my_deque<int, A>::const_iterator i = c.begin(); i != c.end(); ++i)
+            s += *i;
+        sink = s;});
+    std::size_t m = (n < 10000000) ? n : 10000000;
+    time_it(mode, "random at", m, [&] {
+        long          s = 0;
+        unsigned long x = 88172645463325252UL;
+        for (std::size_t i = 0; i != m; ++i) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            s += c.at(x % n);}
+        sink = s;});}
+
+int main (int argc, char* argv[]) {
+    using namespace std;
+    const char* mode = (argc > 1) ? argv[1] : "all";
+    size_t      n    = (argc > 2) ? strtoul(argv[2], 0, 10) : (size_t(1) << 28);
+    bool        all  = strcmp(mode, "all") == 0;
+    cout << "mode,name,n,ns/op" << endl;
+    if (all || (strcmp(mode, "default") == 0))
+        run< std::allocator<int> >("default", n);
+    if (all || (strcmp(mode, "aligned") == 0))
+        run< deque_aligned_allocator<int> >("aligned", n);
+    if (all || (strcmp(mode, "huge") == 0)) {
+        deque_huge_page_region r;
+        run("huge", n, deque_huge_page_allocator<int>(r));
+        cout << "# huge pages " << (r.huge_page_advised() ? "advised" : "not advised") << endl;}
+    if (all || (strcmp(mode, "small") == 0)) {
+        deque_huge_page_region r(size_t(64) << 20, false);
+        run("small", n, deque_huge_page_allocator<int>(r));}
+    return 0;}
@@ -0,0 +1,76 @@
+// // ---------------------------------
+// // projects/deque/BenchDequeRing.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // ---------------------------------
+
+// /*
+// Runs a queue of n ints, pushing at the back and popping at the front, for r rounds
+// of 1024 pairs each, with std::deque, my_deque and ring_deque. Prints the median,
+// 99.9th percentile and worst ns per pair over the rounds, so spikes from allocation
+// and map growth show next to the typical cost.
+
+// To compile the benchmark:
+//     % g++ -O3 -std=c++11 -Wall BenchDequeRing.c++ -o BenchDequeRing
+
+// To run the benchmark (n elements, default 100000; r rounds, default 100000):
+//     % BenchDequeRing [n] [r]
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <algorithm> // sort
+#include <chrono>    // steady_clock
+#include <cstddef>   // size_t
+#include <cstdlib>   // strtoul
+#include <deque>     // deque
+#include <iostream>  // cout
+#include <vector>    // vector
+
+#include "DequeRing.h"
+
+// keeps the optimizer from dropping a result
+volatile long sink;
+
+// pairs in one timed round
+const int round_pairs = 1024;
+
+template <typename D>
+void run (const char* name, D& d, std::size_t n, std::size_t r) {
+    for (std::size_t i = 0; i != n; ++i)
+        d.push_back(int(i));
+    std::vector<double> ns(r);
+    long s = 0;
+    for (std::size_t k = 0; k != r; ++k) {
+        std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();
+        for (int i = 0; i != round_pairs; ++i) {
+            s += d.front();
+            d.pop_front();
+            d.push_back(i);}
+        std::chrono::steady_clock::time_point e = std::chrono::steady_clock::now();
+        ns[k] = std::chrono::duration<double, std::nano>(e - b).count() / round_pairs;}
+    sink = s;
+    std::sort(ns.begin(), ns.end());
+    std::cout << name << "," << n << "," << ns[r / 2] << "," << ns[r - 1 - r / 1000] << "," << ns[r - 1] << std::endl;}
+
+int main (int argc, char* argv[]) {
+    std::size_t n = (argc > 1) ? std::strtoul(argv[1], 0, 10) : 100000;
+    std::size_t r = (argc > 2) ? std::strtoul(argv[2], 0, 10) : 100000;
+    if (r == 0)
+        r = 1;
+    std::cout << "container,n,median,p99.9,max" << std::endl;
+    {
+    std::deque<int> d;
+    run("std::deque", d, n, r);
+    }
+    {
+    my_deque<int> d;
+    run("my_deque", d, n, r);
+    }
+    {
+    ring_deque<int> d(n + 1);
+    run("ring_deque", d, n, r);
+    }
+    return 0;}
@@ -0,0 +1,63 @@
+// // ----------------------------------
+// // projects/deque/BenchDequeSmall.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // ----------------------------------
+
+// /*
+// Times short-lived scratch deques, one per message: build, push k elements
+// at alternating ends, sum them and destroy, for std::deque, my_deque and
+// small_deque with an 8 element buffer. Prints ns and allocator calls per message.
+
+// To compile the benchmark:
+//     % g++ -O3 -std=c++11 -Wall BenchDequeSmall.c++ -o BenchDequeSmall
+
+// To run the benchmark (m messages, default 1000000):
+//     % BenchDequeSmall [m]
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <chrono>   // steady_clock
+#include <cstddef>  // size_t
+#include <cstdlib>  // strtoul
+#include <deque>    // deque
+#include <iostream> // cout
+
+#include "DequeSmall.h"
+#include "DequeCountingAllocator.h"
+
+// keeps the optimizer from dropping a result
+volatile long sink;
+
+// handles m messages of k elements each with a fresh D per message
+template <typename D>
+void run (const char* name, std::size_t m, int k) {
+    counting_allocator_calls() = 0;
+    long s = 0;
+    std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != m; ++i) {
+        D d;
+        for (int j = 0; j != k; ++j)
+            if (j & 1)
+                d.push_front(j);
+            else
+                d.push_back(j);
+        for (typename D::const_iterator p = d.begin(); p != d.end(); ++p)
+            s += *p;}
+    std::chrono::steady_clock::time_point e = std::chrono::steady_clock::now();
+    sink = s;
+    std::cout << name << "," << k << ","
+              << std::chrono::duration<double, std::nano>(e - b).count() / m << ","
+              << double(counting_allocator_calls()) / m << std::endl;}
+
+int main (int argc, char* argv[]) {
+    std::size_t m = (argc > 1) ? std::strtoul(argv[1], 0, 10) : 1000000;
+    std::cout << "container,k,ns/message,allocs/message" << std::endl;
+    for (int k = 0; k <= 16; k += (k < 8) ? 1 : 8) {
+        run< std::deque<int, counting_allocator<int> > >          ("std::deque",  m, k);
+        run< my_deque<int, counting_allocator<int> > >            ("my_deque",    m, k);
+        run< small_deque<int, 8, counting_allocator<int> > >      ("small_deque", m, k);}
+    return 0;}
@@ -0,0 +1,91 @@
+// // ----------------------------------
+// // projects/deque/BenchDequeSpill.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // ----------------------------------
+
+// /*
+// Fills a deque of ints like a backlog, pushing at the back and popping at the front,
+// and reports the time per push and pop and the resident memory at the peak of the backlog,
+// for my_deque and for spill_deque.
+
+// To compile the benchmark:
+//     % g++ -O3 -std=c++11 -Wall BenchDequeSpill.c++ -o BenchDequeSpill -lpthread
+
+// To run the benchmark (mode: memory or spill; n elements, default 268435456; resident blocks, default 64):
+//     % BenchDequeSpill [mode] [n] [resident]
+
+// Run each mode in its own process, so the peak RSS belongs to it alone.
+// To check a 10x backlog, cap the memory, e.g. with systemd-run --user -p MemoryMax=128M,
+// and give n ten times what fits: memory is killed and spill finishes.
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <chrono>   // steady_clock
+#include <cstddef>  // size_t
+#include <cstdio>   // fopen, fscanf
+#include <cstdlib>  // strtoul
+#include <cstring>  // strcmp
+#include <iostream> // cout
+
+#include <sys/resource.h> // getrusage
+#include <unistd.h>       // sysconf
+
+#include "Deque.h"
+#include "DequeSpill.h"
+
+// keeps the optimizer from dropping a result
+volatile long sink;
+
+// resident set size now, in MiB
+double rss_now () {
+    long pages = 0;
+    long size  = 0;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (f) {
+        if (std::fscanf(f, "%ld %ld", &size, &pages) != 2)
+            pages = 0;
+        std::fclose(f);}
+    return double(pages) * sysconf(_SC_PAGESIZE) / (1 << 20);}
+
+// peak resident set size, in MiB
+double rss_peak () {
+    rusage u;
+    getrusage(RUSAGE_SELF, &u);
+    return double(u.ru_maxrss) / 1024;}
+
+template <typename D>
+void backlog (const char* mode, D& d, std::size_t n) {
+    std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != n; ++i)
+        d.push_back(int(i));
+    std::chrono::steady_clock::time_point m = std::chrono::steady_clock::now();
+    double resident = rss_now();
+    long s = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+        s += d.front();
+        d.pop_front();}
+    std::chrono::steady_clock::time_point e = std::chrono::steady_clock::now();
+    sink = s;
+    std::cout << mode << "," << n << ","
+              << std::chrono::duration<double, std::nano>(m - b).count() / n << ","
+              << std::chrono::duration<double, std::nano>(e - m).count() / n << ","
+              << resident << "," << rss_peak() << std::endl;}
+
+int main (int argc, char* argv[]) {
+    using namespace std;
+    const char* mode     = (argc > 1) ? argv[1] : "spill";
+    size_t      n        = (argc > 2) ? strtoul(argv[2], 0, 10) : (size_t(1) << 28);
+    size_t      resident = (argc > 3) ? strtoul(argv[3], 0, 10) : 64;
+    cout << "mode,n,ns/push,ns/pop,MiB resident at peak,MiB max rss" << endl;
+    if (strcmp(mode, "memory") == 0) {
+        my_deque<int> d;
+        backlog(mode, d, n);}
+    else {
+        deque_spill_file  f;
+        spill_deque<int>  d(f, resident);
+        backlog(mode, d, n);}
+    return 0;}
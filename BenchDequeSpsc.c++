@@ -0,0 +1,89 @@
+// // ---------------------------------
+// // projects/deque/BenchDequeSpsc.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // ---------------------------------
+
+// /*
+// Times one producer thread handing n ints to one consumer thread,
+// through spsc_block_queue and through a my_deque guarded by a mutex.
+
+// To compile the benchmark:
+//     % g++ -O3 -std=c++11 -Wall BenchDequeSpsc.c++ -o BenchDequeSpsc -lpthread
+
+// To run the benchmark (n elements, default 10000000):
+//     % BenchDequeSpsc [n]
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <chrono>   // steady_clock
+#include <cstddef>  // size_t
+#include <cstdlib>  // strtoul
+#include <iostream> // cout
+#include <mutex>    // lock_guard, mutex
+#include <thread>   // thread, yield
+
+#include "DequeSpsc.h"
+
+// keeps the optimizer from dropping a result
+volatile long sink;
+
+// a my_deque behind one lock, the usual way to share it
+class locked_deque {
+    private:
+        std::mutex    _m;
+        my_deque<int> _d;
+
+    public:
+        void push (int v) {
+            std::lock_guard<std::mutex> l(_m);
+            _d.push_back(v);}
+
+        bool try_pop (int& x) {
+            std::lock_guard<std::mutex> l(_m);
+            if (_d.empty())
+                return false;
+            x = _d.front();
+            _d.pop_front();
+            return true;}};
+
+// runs f r times and prints the best time and rate
+template <typename F>
+void time_it (const char* name, std::size_t n, F f, int r = 3) {
+    double best = 1e300;
+    for (int i = 0; i < r; ++i) {
+        std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();
+        f();
+        std::chrono::steady_clock::time_point e = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(e - b).count();
+        if (ns < best)
+            best = ns;}
+    std::cout << name << "," << n << "," << best / n << "," << n / best * 1e3 << std::endl;}
+
+template <typename Q>
+void transfer (std::size_t n) {
+    Q q;
+    std::thread producer([&q, n] {
+        for (std::size_t i = 0; i < n; ++i)
+            q.push(int(i));});
+    long s = 0;
+    int  x;
+    for (std::size_t i = 0; i < n;) {
+        if (q.try_pop(x)) {
+            s += x;
+            ++i;}
+        else
+            std::this_thread::yield();}
+    producer.join();
+    sink = s;}
+
+int main (int argc, char* argv[]) {
+    using namespace std;
+    size_t n = (argc > 1) ? strtoul(argv[1], 0, 10) : 10000000;
+    cout << "name,n,ns/element,Melements/s" << endl;
+    time_it("spsc_block_queue", n, [n] {transfer< spsc_block_queue<int> >(n);});
+    time_it("mutex my_deque",   n, [n] {transfer<locked_deque>(n);});
+    return 0;}
@@ -0,0 +1,141 @@
+// // -----------------------------------------
+// // projects/deque/BenchDequeWorkStealing.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // -----------------------------------------
+
+// /*
+// Runs a recursive fork/join workload on a small scheduler with one task
+// deque per worker, idle workers stealing from the others.
+// A task of depth d forks tasks of depth d - 1 down to 0 and then
+// does a little arithmetic, 2^d tasks in all, like a binary tree
+// whose owner keeps the left half.
+// The deques are cache line aligned, so the benchmark needs the C++17 aligned new.
+// The same scheduler runs on work_stealing_deque and on a my_deque
+// guarded by a mutex, for 1 up to the given number of workers.
+
+// To compile the benchmark:
+//     % g++ -O3 -std=c++17 -Wall BenchDequeWorkStealing.c++ -o BenchDequeWorkStealing -lpthread
+
+// To run the benchmark (tree depth, default 20, and most workers, default the hardware threads):
+//     % BenchDequeWorkStealing [depth] [workers]
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <atomic>   // atomic
+#include <chrono>   // steady_clock
+#include <cstddef>  // size_t
+#include <cstdlib>  // strtoul
+#include <iostream> // cout
+#include <memory>   // unique_ptr
+#include <mutex>    // lock_guard, mutex
+#include <thread>   // thread, yield
+#include <vector>   // vector
+
+#include "Deque.h"
+#include "DequeWorkStealing.h"
+
+// keeps the optimizer from dropping a result
+volatile long sink;
+
+// a my_deque behind one lock, owner at the back, thieves at the front
+class locked_deque {
+    private:
+        std::mutex    _m;
+        my_deque<int> _d;
+
+    public:
+        void push_back (int v) {
+            std::lock_guard<std::mutex> l(_m);
+            _d.push_back(v);}
+
+        bool pop_back (int& x) {
+            std::lock_guard<std::mutex> l(_m);
+            if (_d.empty())
+                return false;
+            x = _d.back();
+            _d.pop_back();
+            return true;}
+
+        bool steal (int& x) {
+            std::lock_guard<std::mutex> l(_m);
+            if (_d.empty())
+                return false;
+            x = _d.front();
+            _d.pop_front();
+            return true;}};
+
+// the leaf work, enough that a task is not free
+inline long leaf (int seed) {
+    long s = seed;
+    for (int i = 0; i < 50; ++i)
+        s = s * 1103515245 + 12345;
+    return s & 1;}
+
+// runs the tree of the given depth on w workers and returns the seconds it took
+template <typename Q>
+double schedule (int depth, std::size_t w) {
+    std::vector<std::unique_ptr<Q> > q;
+    for (std::size_t i = 0; i != w; ++i)
+        q.push_back(std::unique_ptr<Q>(new Q));
+    std::atomic<long> pending(1);
+    std::atomic<long> total(0);
+    q[0]->push_back(depth);
+
+    auto work = [&] (std::size_t me) {
+        long     s      = 0;
+        unsigned victim = unsigned(me);
+        int      d;
+        while (pending.load(std::memory_order_acquire) != 0) {
+            bool found = q[me]->pop_back(d);
+            for (std::size_t k = 1; !found && (k != w); ++k) {
+                victim = (victim + 1) % unsigned(w);
+                if (victim != me)
+                    found = q[victim]->steal(d);}
+            if (!found) {
+                std::this_thread::yield();
+                continue;}
+            // fork the right halves, keep walking down the left
+            while (d > 0) {
+                pending.fetch_add(1, std::memory_order_relaxed);
+                q[me]->push_back(--d);}
+            s += leaf(d);
+            pending.fetch_sub(1, std::memory_order_release);}
+        total += s;};
+
+    std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();
+    std::vector<std::thread> t;
+    for (std::size_t i = 1; i < w; ++i)
+        t.push_back(std::thread(work, i));
+    work(0);
+    for (std::size_t i = 0; i != t.size(); ++i)
+        t[i].join();
+    std::chrono::steady_clock::time_point e = std::chrono::steady_clock::now();
+    sink = total.load();
+    return std::chrono::duration<double>(e - b).count();}
+
+// prints the best of r runs
+template <typename Q>
+void time_it (const char* name, int depth, std::size_t w, int r = 3) {
+    double best = 1e300;
+    for (int i = 0; i < r; ++i) {
+        double s = schedule<Q>(depth, w);
+        if (s < best)
+            best = s;}
+    double tasks = double(1L << depth);
+    std::cout << name << "," << w << "," << depth << "," << best * 1e3 << "," << best * 1e9 / tasks << std::endl;}
+
+int main (int argc, char* argv[]) {
+    using namespace std;
+    int    depth = (argc > 1) ? int(strtoul(argv[1], 0, 10)) : 20;
+    size_t most  = (argc > 2) ? strtoul(argv[2], 0, 10) : thread::hardware_concurrency();
+    if (most == 0)
+        most = 1;
+    cout << "name,workers,depth,ms,ns/task" << endl;
+    for (size_t w = 1; w <= most; w *= 2) {
+        time_it< work_stealing_deque<int> >("work_stealing_deque", depth, w);
+        time_it<locked_deque>              ("mutex my_deque",      depth, w);}
+    return 0;}
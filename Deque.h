@@ -11,12 +11,16 @@
 // includes
 // --------
 
-#include <algorithm> // copy, equal, lexicographical_compare, max, swap
+#include <algorithm> // copy, equal, fill, lexicographical_compare, max, min, move, move_backward, reverse, rotate, swap
 #include <cassert>   // assert
-#include <iterator>  // iterator, bidirectional_iterator_tag
-#include <memory>    // allocator
-#include <stdexcept> // out_of_range
-#include <utility>   // !=, <=, >, >=
+#include <cstddef>   // ptrdiff_t, size_t
+#include <cstdint>   // uint32_t, uint64_t
+#include <cstring>   // memcpy
+#include <iterator>  // advance, distance, iterator_traits, random_access_iterator_tag
+#include <memory>    // allocator, allocator_traits
+#include <stdexcept> // out_of_range, runtime_error
+#include <type_traits> // enable_if, is_convertible, is_same, is_trivially_copyable, is_trivially_destructible, remove_const, remove_cv
+#include <utility>   // !=, <=, >, >=, forward, move
 #include <iostream>  // for prints
 
 // -----
@@ -35,9 +39,10 @@ using std::rel_ops::operator>=;
 
 template <typename A, typename BI>
 BI destroy (A& a, BI b, BI e) {
-    while (b != e) {
-        --e;
-        a.destroy(&*e);}
+    if (!std::is_trivially_destructible<typename std::iterator_traits<BI>::value_type>::value)
+        while (b != e) {
+            --e;
+            std::allocator_traits<A>::destroy(a, &*e);}
     return b;}
 
 // ------------------
@@ -49,7 +54,7 @@ BI uninitialized_copy (A& a, II b, II e, BI x) {
     BI p = x;
     try {
         while (b != e) {
-            a.construct(&*x, *b);
+            std::allocator_traits<A>::construct(a, &*x, *b);
             ++b;
             ++x;}}
     catch (...) {
@@ -57,6 +62,17 @@ BI uninitialized_copy (A& a, II b, II e, BI x) {
         throw;}
     return x;}
 
+/**
+ * contiguous runs of a trivially copyable type are copied with one memcpy
+ */
+template <typename A, typename U, typename T>
+typename std::enable_if<std::is_same<typename std::remove_cv<U>::type, T>::value &&
+                        std::is_trivially_copyable<T>::value, T*>::type
+uninitialized_copy (A&, U* b, U* e, T* x) {
+    if (b != e)
+        std::memcpy(static_cast<void*>(x), static_cast<const void*>(b), (e - b) * sizeof(T));
+    return x + (e - b);}
+
 // ------------------
 // uninitialized_fill
 // ------------------
@@ -66,35 +82,457 @@ BI uninitialized_fill (A& a, BI b, BI e, const U& v) {
     BI p = b;
     try {
         while (b != e) {
-            a.construct(&*b, v);
+            std::allocator_traits<A>::construct(a, &*b, v);
             ++b;}}
     catch (...) {
         destroy(a, p, b);
         throw;}
     return e;}
 
+/**
+ * contiguous runs of a trivially copyable type are filled without construct calls
+ */
+template <typename A, typename T>
+typename std::enable_if<std::is_trivially_copyable<T>::value, T*>::type
+uninitialized_fill (A&, T* b, T* e, const T& v) {
+    std::fill(b, e, v);
+    return e;}
+
+// --------------------
+// deque_copy_allocator
+// --------------------
+
+/**
+ * x = y when the allocator propagates, nothing otherwise
+ * polymorphic allocators cannot be assigned, so the assignment must not even be instantiated
+ */
+template <typename A>
+void deque_copy_allocator (A& x, const A& y, std::true_type) {
+    x = y;}
+
+template <typename A>
+void deque_copy_allocator (A&, const A&, std::false_type) {}
+
+// --------------------
+// deque_move_allocator
+// --------------------
+
+template <typename A>
+void deque_move_allocator (A& x, A& y, std::true_type) {
+    x = std::move(y);}
+
+template <typename A>
+void deque_move_allocator (A&, A&, std::false_type) {}
+
+// --------------------
+// deque_swap_allocator
+// --------------------
+
+template <typename A>
+void deque_swap_allocator (A& x, A& y, std::true_type) {
+    std::swap(x, y);}
+
+/**
+ * allocators that do not propagate on swap must be equal
+ */
+template <typename A>
+void deque_swap_allocator (A& x, A& y, std::false_type) {
+    assert(x == y);
+    (void) x;
+    (void) y;}
+
+// -------------------
+// deque_binary_header
+// -------------------
+
+/**
+ * the header of my_deque's binary format, followed by count elements in the layout of T
+ * the fields are written in host byte order, order_word tells a reader if that is not its own
+ */
+struct deque_binary_header {
+    // "MYDQ" read as a little endian word
+    static const std::uint32_t magic_word   = 0x5144594d;
+    static const std::uint32_t version_word = 1;
+    static const std::uint32_t order_word   = 0x01020304;
+
+    std::uint32_t element_size;
+    std::uint64_t count;
+
+    /**
+     * writes the header to out
+     */
+    void write (std::ostream& out) const {
+        std::uint32_t w[4] = {magic_word, version_word, order_word, element_size};
+        out.write(reinterpret_cast<const char*>(w), sizeof(w));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));}
+
+    /**
+     * reads a header for elements of s bytes from in
+     * throws std::runtime_error if it is not one
+     */
+    static deque_binary_header read (std::istream& in, std::size_t s) {
+        std::uint32_t       w[4];
+        deque_binary_header h;
+        if (!in.read(reinterpret_cast<char*>(w), sizeof(w)) || (w[0] != magic_word))
+            throw std::runtime_error("deque_binary_header: not a my_deque stream");
+        if (w[1] != version_word)
+            throw std::runtime_error("deque_binary_header: unknown version");
+        if (w[2] != order_word)
+            throw std::runtime_error("deque_binary_header: written with another byte order");
+        if (w[3] != s)
+            throw std::runtime_error("deque_binary_header: element size does not match");
+        if (!in.read(reinterpret_cast<char*>(&h.count), sizeof(h.count)))
+            throw std::runtime_error("deque_binary_header: truncated header");
+        h.element_size = w[3];
+        return h;}};
+
+// -----------
+// deque_stats
+// -----------
+
+/**
+ * what a my_deque has done since it was built or its stats were last reset
+ * the counters are kept only by a my_deque<T, A, BS, deque_counting_stats>, otherwise they stay zero
+ */
+struct deque_stats {
+    std::uint64_t block_allocations;
+    std::uint64_t block_deallocations;
+    std::uint64_t map_reallocations;
+    std::uint64_t map_bytes_copied;
+    std::uint64_t elements_shifted;
+    std::uint64_t peak_size;
+    std::uint64_t peak_capacity;
+
+    deque_stats () :
+            block_allocations   (0),
+            block_deallocations (0),
+            map_reallocations   (0),
+            map_bytes_copied    (0),
+            elements_shifted    (0),
+            peak_size           (0),
+            peak_capacity       (0)
+        {}};
+
+// --------------
+// deque_no_stats
+// --------------
+
+/**
+ * the stats policy of my_deque that keeps nothing, its hooks compile away
+ * my_deque derives from its policy, so this one takes no space either
+ */
+struct deque_no_stats {
+    void stat_peaks      (std::size_t, std::size_t) {}
+    void stat_allocate   (std::size_t, std::size_t) {}
+    void stat_deallocate ()                         {}
+    void stat_map        (std::size_t)              {}
+    void stat_shift      (std::size_t)              {}
+    void stat_take       (deque_no_stats&)          {}
+    void stat_swap       (deque_no_stats&)          {}
+    void stat_reset      ()                         {}
+
+    const deque_stats& stat_counters () const {
+        static const deque_stats none;
+        return none;}};
+
+// --------------------
+// deque_counting_stats
+// --------------------
+
+/**
+ * the stats policy of my_deque that keeps a deque_stats and the number of blocks held
+ * the policy is part of the type, so deques with and without counters never mix
+ */
+struct deque_counting_stats {
+    private:
+        deque_stats _counters;
+        std::size_t _blocks;
+
+    public:
+        deque_counting_stats () :
+                _blocks (0)
+            {}
+
+        /**
+         * raises the peaks to a size of s and the blocks held, of bs elements each
+         */
+        void stat_peaks (std::size_t s, std::size_t bs) {
+            _counters.peak_size     = std::max<std::uint64_t>(_counters.peak_size,     s);
+            _counters.peak_capacity = std::max<std::uint64_t>(_counters.peak_capacity, _blocks * bs);}
+
+        void stat_allocate (std::size_t s, std::size_t bs) {
+            ++_counters.block_allocations;
+            ++_blocks;
+            stat_peaks(s, bs);}
+
+        void stat_deallocate () {
+            ++_counters.block_deallocations;
+            --_blocks;}
+
+        /**
+         * counts a new map, bytes of block pointers copied into it
+         */
+        void stat_map (std::size_t bytes) {
+            ++_counters.map_reallocations;
+            _counters.map_bytes_copied += bytes;}
+
+        void stat_shift (std::size_t n) {
+            _counters.elements_shifted += n;}
+
+        /**
+         * takes over that's blocks along with its map, the counters stay with each deque
+         */
+        void stat_take (deque_counting_stats& that) {
+            _blocks      = that._blocks;
+            that._blocks = 0;}
+
+        void stat_swap (deque_counting_stats& that) {
+            std::swap(_blocks, that._blocks);}
+
+        void stat_reset () {
+            _counters = deque_stats();}
+
+        const deque_stats& stat_counters () const {
+            return _counters;}};
+
+// ----------------
+// deque_floor_pow2
+// ----------------
+
+/**
+ * largest power of two that is <= n (1 if n is 0)
+ */
+constexpr std::size_t deque_floor_pow2 (std::size_t n, std::size_t p = 1) {
+    return ((p << 1) != 0 && (p << 1) <= n) ? deque_floor_pow2(n, p << 1) : p;}
+
+// ----------
+// deque_log2
+// ----------
+
+/**
+ * floor of log base 2 of n
+ */
+constexpr std::size_t deque_log2 (std::size_t n) {
+    return (n <= 1) ? 0 : 1 + deque_log2(n >> 1);}
+
+// ----------------
+// deque_block_size
+// ----------------
+
+/**
+ * default number of elements per block
+ * the largest power of two whose block fits in Bytes bytes (at least 1)
+ */
+template <typename T, std::size_t Bytes = 4096>
+struct deque_block_size {
+    static const std::size_t value = deque_floor_pow2(Bytes / sizeof(T));};
+
+// --------------------
+// deque_index_iterator
+// --------------------
+
+/**
+ * a random access iterator holding a container and an index into it,
+ * for containers that find their elements through operator []
+ * C is the container or const container, V is its value type or const value type
+ */
+template <typename C, typename V>
+class deque_index_iterator {
+    template <typename, typename>
+    friend class deque_index_iterator;
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef std::random_access_iterator_tag     iterator_category;
+        typedef typename std::remove_const<V>::type value_type;
+        typedef std::ptrdiff_t                      difference_type;
+        typedef V*                                  pointer;
+        typedef V&                                  reference;
+
+    public:
+        // -----------
+        // operator ==
+        // -----------
+
+        friend bool operator == (const deque_index_iterator& lhs, const deque_index_iterator& rhs) {
+            return lhs._i == rhs._i;}
+
+        friend bool operator != (const deque_index_iterator& lhs, const deque_index_iterator& rhs) {
+            return !(lhs == rhs);}
+
+        // ----------
+        // operator <
+        // ----------
+
+        friend bool operator < (const deque_index_iterator& lhs, const deque_index_iterator& rhs) {
+            return lhs._i < rhs._i;}
+
+        friend bool operator > (const deque_index_iterator& lhs, const deque_index_iterator& rhs) {
+            return rhs < lhs;}
+
+        friend bool operator <= (const deque_index_iterator& lhs, const deque_index_iterator& rhs) {
+            return !(rhs < lhs);}
+
+        friend bool operator >= (const deque_index_iterator& lhs, const deque_index_iterator& rhs) {
+            return !(lhs < rhs);}
+
+        // ----------
+        // operator +
+        // ----------
+
+        friend deque_index_iterator operator + (deque_index_iterator lhs, difference_type rhs) {
+            return lhs += rhs;}
+
+        friend deque_index_iterator operator + (difference_type lhs, deque_index_iterator rhs) {
+            return rhs += lhs;}
+
+        // ----------
+        // operator -
+        // ----------
+
+        friend deque_index_iterator operator - (deque_index_iterator lhs, difference_type rhs) {
+            return lhs -= rhs;}
+
+        friend difference_type operator - (const deque_index_iterator& lhs, const deque_index_iterator& rhs) {
+            return lhs._i - rhs._i;}
+
+    private:
+        // ----
+        // data
+        // ----
+
+        C*              _c;
+        difference_type _i;
+
+    public:
+        // -----------
+        // constructor
+        // -----------
+
+        deque_index_iterator () :
+                _c (0),
+                _i (0)
+            {}
+
+        deque_index_iterator (C* c, difference_type i) :
+                _c (c),
+                _i (i)
+            {}
+
+        /**
+         * an iterator converts to a const_iterator
+         */
+        template <typename C2, typename V2,
+                  typename = typename std::enable_if<std::is_convertible<C2*, C*>::value>::type>
+        deque_index_iterator (const deque_index_iterator<C2, V2>& that) :
+                _c (that._c),
+                _i (that._i)
+            {}
+
+        // ----------
+        // operator *
+        // ----------
+
+        reference operator * () const {
+            return (*_c)[_i];}
+
+        // -----------
+        // operator ->
+        // -----------
+
+        pointer operator -> () const {
+            return &**this;}
+
+        // -----------
+        // operator []
+        // -----------
+
+        reference operator [] (difference_type n) const {
+            return (*_c)[_i + n];}
+
+        // -----------
+        // operator ++
+        // -----------
+
+        deque_index_iterator& operator ++ () {
+            ++_i;
+            return *this;}
+
+        deque_index_iterator operator ++ (int) {
+            deque_index_iterator x = *this;
+            ++_i;
+            return x;}
+
+        // -----------
+        // operator --
+        // -----------
+
+        deque_index_iterator& operator -- () {
+            --_i;
+            return *this;}
+
+        deque_index_iterator operator -- (int) {
+            deque_index_iterator x = *this;
+            --_i;
+            return x;}
+
+        // -----------
+        // operator +=
+        // -----------
+
+        deque_index_iterator& operator += (difference_type n) {
+            _i += n;
+            return *this;}
+
+        // -----------
+        // operator -=
+        // -----------
+
+        deque_index_iterator& operator -= (difference_type n) {
+            _i -= n;
+            return *this;}};
+
 // -------
 // my_deque
 // -------
 
-template < typename T, typename A = std::allocator<T> >
-class my_deque {
+template < typename T, typename A = std::allocator<T>, std::size_t BS = deque_block_size<T>::value,
+           typename SP = deque_no_stats >
+class my_deque : private SP {
+    static_assert(BS > 0, "my_deque: block size must be positive");
+
     public:
         // --------
         // typedefs
         // --------
 
-        typedef A                                        allocator_type;
-        typedef typename allocator_type::value_type      value_type;
+        typedef A                                                  allocator_type;
+        typedef typename allocator_type::value_type                value_type;
+
+        typedef typename std::allocator_traits<A>::size_type       size_type;
+        typedef typename std::allocator_traits<A>::difference_type difference_type;
+
+        typedef typename std::allocator_traits<A>::pointer         pointer;
+        typedef typename std::allocator_traits<A>::const_pointer   const_pointer;
 
-        typedef typename allocator_type::size_type       size_type;
-        typedef typename allocator_type::difference_type difference_type;
+        typedef value_type&                                        reference;
+        typedef const value_type&                                  const_reference;
+
+        // what the deque counts, deque_no_stats or deque_counting_stats
+        typedef SP                                                 stats_policy;
+
+        // ----------
+        // block size
+        // ----------
 
-        typedef typename allocator_type::pointer         pointer;
-        typedef typename allocator_type::const_pointer   const_pointer;
+        // number of elements in each block
+        static const size_type block_size = BS;
 
-        typedef typename allocator_type::reference       reference;
-        typedef typename allocator_type::const_reference const_reference;
+        // empty blocks kept at each end of a new deque
+        static const size_type default_spare_blocks = 2;
 
     public:
         // -----------
@@ -119,23 +557,34 @@ class my_deque {
         friend bool operator < (const my_deque& lhs, const my_deque& rhs) {
             return lexicographical_compare(lhs.begin(),lhs.end(),rhs.begin(),rhs.end());}
 
+        // ----
+        // swap
+        // ----
+
+        /**
+         * swaps the values of the deques in constant time
+         */
+        friend void swap (my_deque& lhs, my_deque& rhs) noexcept {
+            lhs.swap(rhs);}
+
     private:
         // ----
         // data
         // ----
 
         allocator_type _a;
-        std::allocator<T*> _pa;
 
         size_t _size;
 
         // start data
         pointer _b;
 
-        // end data
+        // end data (one past the last element, always inside *_ei)
         pointer _e;
 
         // pointers to the begin/end (data) blocks
+        // there is always at least one map slot ahead of _bi, and it holds a block
+        // slots outside [_bi - 1, _ei] may be null
         T** _bi;
         T** _ei;
 
@@ -143,15 +592,68 @@ class my_deque {
         T** _cbi;
         T** _cei;
 
+        // the map, null when no storage has been allocated yet
         T** _cont;
 
+        // most empty blocks kept at each end, the rest go back to the allocator
+        size_type _spare;
+
+        // pushes at each end that reserve_front and reserve_back promised will not allocate
+        size_type _reserve_front;
+        size_type _reserve_back;
+
     private:
+        // --------
+        // typedefs
+        // --------
+
+        // the map comes from A too, rebound to block pointers
+        typedef typename std::allocator_traits<A>::template rebind_alloc<T*> map_allocator_type;
+
+        typedef std::allocator_traits<A>                  traits;
+        typedef std::allocator_traits<map_allocator_type> map_traits;
+
+        // -------------
+        // map_allocator
+        // -------------
+
+        /**
+         * a map allocator made from _a on demand, so that it always follows _a
+         */
+        map_allocator_type map_allocator () const {
+            return map_allocator_type(_a);}
+
         // -----
         // valid
         // -----
 
-        bool valid () const { 
-            return (!_b && !_e && !_cei) || (_bi <= _ei);}
+        bool valid () const {
+            if (!_cont)
+                return !_cbi && !_cei && !_bi && !_ei && !_b && !_e && !_size;
+            return (_cbi == _cont) && (_cbi < _bi) && *(_bi - 1) && (_bi <= _ei) && (_ei <= _cei) &&
+                   (_b >= *_bi) && (_b < *_bi + BS) && (_e >= *_ei) && (_e < *_ei + BS);}
+
+        // ------------
+        // block_index
+        // ------------
+
+        /**
+         * which block (relative to _bi) an offset from *_bi falls in
+         * shifts when the block size is a power of two
+         */
+        static size_type block_index (size_type o) {
+            return ((BS & (BS - 1)) == 0) ? (o >> deque_log2(BS)) : (o / BS);}
+
+        // ------------
+        // block_offset
+        // ------------
+
+        /**
+         * where in its block an offset from *_bi falls
+         * masks when the block size is a power of two
+         */
+        static size_type block_offset (size_type o) {
+            return ((BS & (BS - 1)) == 0) ? (o & (BS - 1)) : (o % BS);}
 
     public:
         // --------
@@ -159,12 +661,15 @@ class my_deque {
         // --------
 
         class iterator {
+            friend class my_deque;
+            friend class const_iterator;
+
             public:
                 // --------
                 // typedefs
                 // --------
 
-                typedef std::bidirectional_iterator_tag   iterator_category;
+                typedef std::random_access_iterator_tag    iterator_category;
                 typedef typename my_deque::value_type      value_type;
                 typedef typename my_deque::difference_type difference_type;
                 typedef typename my_deque::pointer         pointer;
@@ -176,18 +681,45 @@ class my_deque {
                 // -----------
 
                 /**
-                 * returns true if iterators point to same deque at same index
+                 * returns true if iterators point to the same element
                  */
                 friend bool operator == (const iterator& lhs, const iterator& rhs) {
-                    return (lhs._p == rhs._p) && (lhs._index == rhs._index);
-                    return true;}
+                    return lhs._cur == rhs._cur;}
 
                 /**
-                 * returns false if iterators point to same deque at same index
+                 * returns false if iterators point to the same element
                  */
                 friend bool operator != (const iterator& lhs, const iterator& rhs) {
                     return !(lhs == rhs);}
 
+                // ----------
+                // operator <
+                // ----------
+
+                /**
+                 * returns true if lhs comes before rhs in the deque
+                 */
+                friend bool operator < (const iterator& lhs, const iterator& rhs) {
+                    return (lhs._node == rhs._node) ? (lhs._cur < rhs._cur) : (lhs._node < rhs._node);}
+
+                /**
+                 * returns true if lhs comes after rhs in the deque
+                 */
+                friend bool operator > (const iterator& lhs, const iterator& rhs) {
+                    return rhs < lhs;}
+
+                /**
+                 * returns true if lhs does not come after rhs in the deque
+                 */
+                friend bool operator <= (const iterator& lhs, const iterator& rhs) {
+                    return !(rhs < lhs);}
+
+                /**
+                 * returns true if lhs does not come before rhs in the deque
+                 */
+                friend bool operator >= (const iterator& lhs, const iterator& rhs) {
+                    return !(lhs < rhs);}
+
                 // ----------
                 // operator +
                 // ----------
@@ -198,6 +730,12 @@ class my_deque {
                 friend iterator operator + (iterator lhs, difference_type rhs) {
                     return lhs += rhs;}
 
+                /**
+                 * + index of iterator, offset first
+                 */
+                friend iterator operator + (difference_type lhs, iterator rhs) {
+                    return rhs += lhs;}
+
                 // ----------
                 // operator -
                 // ----------
@@ -208,36 +746,72 @@ class my_deque {
                 friend iterator operator - (iterator lhs, difference_type rhs) {
                     return lhs -= rhs;}
 
+                /**
+                 * number of elements from rhs to lhs
+                 */
+                friend difference_type operator - (const iterator& lhs, const iterator& rhs) {
+                    return difference_type(BS) * (lhs._node - rhs._node) +
+                           ((lhs._cur - lhs._last) - (rhs._cur - rhs._last));}
+
             private:
                 // ----
                 // data
                 // ----
 
-                my_deque* _p;
-                size_t _index;
+                // current element
+                pointer _cur;
+
+                // one past the end of the current block
+                pointer _last;
+
+                // map slot of the current block
+                T** _node;
 
             private:
                 // -----
                 // valid
                 // -----
 
-                bool valid () const { 
-                    return (_index >= 0 && _index <= _p->size());}
+                bool valid () const {
+                    return (!_cur && !_last && !_node) ||
+                           ((_last == *_node + BS) && (_cur >= *_node) && (_cur < _last));}
+
+                // --------
+                // set_node
+                // --------
+
+                /**
+                 * moves the iterator onto the block at map slot n
+                 */
+                void set_node (T** n) {
+                    _node = n;
+                    _last = *n + BS;}
 
-            public:
                 // -----------
                 // constructor
                 // -----------
 
                 /**
-                 * constructor given a deque and index
+                 * constructor given an element and the map slot of its block
                  */
-                iterator (my_deque* p, size_t index) :
+                iterator (pointer cur, T** node) :
+                        _cur  (cur),
+                        _last (node ? *node + BS : 0),
+                        _node (node) {
+                    assert(valid());}
 
-                    _p(p),
-                    _index(index)
+            public:
+                // -----------
+                // constructor
+                // -----------
 
-                    {
+                /**
+                 * singular iterator
+                 */
+                iterator () :
+                        _cur  (0),
+                        _last (0),
+                        _node (0) {
                     assert(valid());}
 
                 // Default copy, destructor, and copy assignment.
@@ -250,10 +824,10 @@ class my_deque {
                 // ----------
 
                 /**
-                 * returns value in deque at index
+                 * returns the element the iterator points to
                  */
                 reference operator * () const {
-                    return (*_p)[_index];}
+                    return *_cur;}
 
                 // -----------
                 // operator ->
@@ -263,21 +837,34 @@ class my_deque {
                  * derefence shorthand for iterator
                  */
                 pointer operator -> () const {
-                    return &**this;}
+                    return _cur;}
+
+                // -----------
+                // operator []
+                // -----------
+
+                /**
+                 * returns the element d past the iterator
+                 */
+                reference operator [] (difference_type d) const {
+                    return *(*this + d);}
 
                 // -----------
                 // operator ++
                 // -----------
 
                 /**
-                 * ++ index of iterator pre
+                 * ++ iterator pre, stepping to the next block at the end of this one
                  */
                 iterator& operator ++ () {
-                    ++_index;
+                    if (++_cur == _last) {
+                        set_node(_node + 1);
+                        _cur = *_node;}
+                    assert(valid());
                     return *this;}
 
                 /**
-                 * ++ index of iterator post
+                 * ++ iterator post
                  */
                 iterator operator ++ (int) {
                     iterator x = *this;
@@ -290,18 +877,21 @@ class my_deque {
                 // -----------
 
                 /**
-                 * -- index of iterator pre
+                 * -- iterator pre, stepping to the previous block at the start of this one
                  */
                 iterator& operator -- () {
-                    if(_index != 0)
-                        --_index;
+                    if (_cur == _last - BS) {
+                        set_node(_node - 1);
+                        _cur = _last;}
+                    --_cur;
+                    assert(valid());
                     return *this;}
 
                 /**
-                 * -- index of iterator post
+                 * -- iterator post
                  */
                 iterator operator -- (int) {
-                    iterator x = *this;                    
+                    iterator x = *this;
                     --(*this);
                     assert(valid());
                     return x;}
@@ -311,10 +901,19 @@ class my_deque {
                 // -----------
 
                 /**
-                 * += index of iterator
+                 * += iterator, jumping straight to the right block
+                 * the iterators of a deque with no map are null and only ever move by 0
                  */
                 iterator& operator += (difference_type d) {
-                    _index += d;
+                    difference_type o = (_cur - _last) + difference_type(BS) + d;
+                    if ((o >= 0) && (o < difference_type(BS)))
+                        _cur += d;
+                    else if (d != 0) {
+                        difference_type n = (o > 0) ?
+                            difference_type(block_index(o)) :
+                            -difference_type(block_index(-o - 1)) - 1;
+                        set_node(_node + n);
+                        _cur = (_last - BS) + (o - n * difference_type(BS));}
                     assert(valid());
                     return *this;}
 
@@ -323,12 +922,10 @@ class my_deque {
                 // -----------
 
                 /**
-                 * -= index of iterator
+                 * -= iterator
                  */
                 iterator& operator -= (difference_type d) {
-                    _index -= d;
-                    assert(valid());
-                    return *this;}};
+                    return *this += -d;}};
 
     public:
         // --------------
@@ -336,12 +933,14 @@ class my_deque {
         // --------------
 
         class const_iterator {
+            friend class my_deque;
+
             public:
                 // --------
                 // typedefs
                 // --------
 
-                typedef std::bidirectional_iterator_tag   iterator_category;
+                typedef std::random_access_iterator_tag    iterator_category;
                 typedef typename my_deque::value_type      value_type;
                 typedef typename my_deque::difference_type difference_type;
                 typedef typename my_deque::const_pointer   pointer;
@@ -353,18 +952,45 @@ class my_deque {
                 // -----------
 
                 /**
-                 * returns true if the iterators point to the same index of same deque
+                 * returns true if the const iterators point to the same element
                  */
                 friend bool operator == (const const_iterator& lhs, const const_iterator& rhs) {
-                    return (lhs._p == rhs._p) && (lhs._index == rhs._index);}
-
+                    return lhs._cur == rhs._cur;}
 
                 /**
-                 * returns false if the iterators point to the same index of same deque
+                 * returns false if the const iterators point to the same element
                  */
                 friend bool operator != (const const_iterator& lhs, const const_iterator& rhs) {
                     return !(lhs == rhs);}
 
+                // ----------
+                // operator <
+                // ----------
+
+                /**
+                 * returns true if lhs comes before rhs in the deque
+                 */
+                friend bool operator < (const const_iterator& lhs, const const_iterator& rhs) {
+                    return (lhs._node == rhs._node) ? (lhs._cur < rhs._cur) : (lhs._node < rhs._node);}
+
+                /**
+                 * returns true if lhs comes after rhs in the deque
+                 */
+                friend bool operator > (const const_iterator& lhs, const const_iterator& rhs) {
+                    return rhs < lhs;}
+
+                /**
+                 * returns true if lhs does not come after rhs in the deque
+                 */
+                friend bool operator <= (const const_iterator& lhs, const const_iterator& rhs) {
+                    return !(rhs < lhs);}
+
+                /**
+                 * returns true if lhs does not come before rhs in the deque
+                 */
+                friend bool operator >= (const const_iterator& lhs, const const_iterator& rhs) {
+                    return !(lhs < rhs);}
+
                 // ----------
                 // operator +
                 // ----------
@@ -375,6 +1001,12 @@ class my_deque {
                 friend const_iterator operator + (const_iterator lhs, difference_type rhs) {
                     return lhs += rhs;}
 
+                /**
+                 * + the index of const iterator, offset first
+                 */
+                friend const_iterator operator + (difference_type lhs, const_iterator rhs) {
+                    return rhs += lhs;}
+
                 // ----------
                 // operator -
                 // ----------
@@ -385,13 +1017,26 @@ class my_deque {
                 friend const_iterator operator - (const_iterator lhs, difference_type rhs) {
                     return lhs -= rhs;}
 
+                /**
+                 * number of elements from rhs to lhs
+                 */
+                friend difference_type operator - (const const_iterator& lhs, const const_iterator& rhs) {
+                    return difference_type(BS) * (lhs._node - rhs._node) +
+                           ((lhs._cur - lhs._last) - (rhs._cur - rhs._last));}
+
             private:
                 // ----
                 // data
                 // ----
 
-                size_type _index;
-                const my_deque* _p;
+                // current element
+                const_pointer _cur;
+
+                // one past the end of the current block
+                const_pointer _last;
+
+                // map slot of the current block
+                T* const* _node;
 
             private:
                 // -----
@@ -399,22 +1044,54 @@ class my_deque {
                 // -----
 
                 bool valid () const {
-                    return true;}//(_index >= 0 && _index <= _p->size());}
+                    return (!_cur && !_last && !_node) ||
+                           ((_last == *_node + BS) && (_cur >= *_node) && (_cur < _last));}
+
+                // --------
+                // set_node
+                // --------
+
+                /**
+                 * moves the const iterator onto the block at map slot n
+                 */
+                void set_node (T* const* n) {
+                    _node = n;
+                    _last = *n + BS;}
 
-            public:
                 // -----------
                 // constructor
                 // -----------
 
                 /**
-                 * constructor that sets the iterator according to an index
+                 * constructor given an element and the map slot of its block
                  */
-                const_iterator (const my_deque* p, size_t index) :
+                const_iterator (const_pointer cur, T* const* node) :
+                        _cur  (cur),
+                        _last (node ? *node + BS : 0),
+                        _node (node) {
+                    assert(valid());}
+
+            public:
+                // -----------
+                // constructor
+                // -----------
 
-                    _index(index),
-                    _p(p)
+                /**
+                 * singular const iterator
+                 */
+                const_iterator () :
+                        _cur  (0),
+                        _last (0),
+                        _node (0) {
+                    assert(valid());}
 
-                    {
+                /**
+                 * const iterator to the same element as an iterator
+                 */
+                const_iterator (const iterator& that) :
+                        _cur  (that._cur),
+                        _last (that._last),
+                        _node (that._node) {
                     assert(valid());}
 
                 // Default copy, destructor, and copy assignment.
@@ -427,10 +1104,10 @@ class my_deque {
                 // ----------
 
                 /**
-                 * returns the value of the deque that the const iterator is pointing to
+                 * returns the element the const iterator points to
                  */
                 reference operator * () const {
-                    return (*_p)[_index];}
+                    return *_cur;}
 
                 // -----------
                 // operator ->
@@ -440,22 +1117,34 @@ class my_deque {
                  * derefrence shorthand for const iterator
                  */
                 pointer operator -> () const {
-                    return &**this;}
+                    return _cur;}
+
+                // -----------
+                // operator []
+                // -----------
+
+                /**
+                 * returns the element d past the const iterator
+                 */
+                reference operator [] (difference_type d) const {
+                    return *(*this + d);}
 
                 // -----------
                 // operator ++
                 // -----------
 
                 /**
-                 * pre ++ the index of const iterator
+                 * pre ++ the const iterator, stepping to the next block at the end of this one
                  */
                 const_iterator& operator ++ () {
-                    ++_index;
+                    if (++_cur == _last) {
+                        set_node(_node + 1);
+                        _cur = *_node;}
                     assert(valid());
                     return *this;}
 
                 /**
-                 * post ++ the index of const iterator
+                 * post ++ the const iterator
                  */
                 const_iterator operator ++ (int) {
                     const_iterator x = *this;
@@ -468,15 +1157,18 @@ class my_deque {
                 // -----------
 
                 /**
-                 * pre -- the index of const iterator
+                 * pre -- the const iterator, stepping to the previous block at the start of this one
                  */
                 const_iterator& operator -- () {
-                    --_index;
+                    if (_cur == _last - BS) {
+                        set_node(_node - 1);
+                        _cur = _last;}
+                    --_cur;
                     assert(valid());
                     return *this;}
 
                 /**
-                 * post -- the index of const iterator
+                 * post -- the const iterator
                  */
                 const_iterator operator -- (int) {
                     const_iterator x = *this;
@@ -489,10 +1181,19 @@ class my_deque {
                 // -----------
 
                 /**
-                 * += the index of const iterator
+                 * += the const iterator, jumping straight to the right block
+                 * the iterators of a deque with no map are null and only ever move by 0
                  */
                 const_iterator& operator += (difference_type d) {
-                    _index += d;
+                    difference_type o = (_cur - _last) + difference_type(BS) + d;
+                    if ((o >= 0) && (o < difference_type(BS)))
+                        _cur += d;
+                    else if (d != 0) {
+                        difference_type n = (o > 0) ?
+                            difference_type(block_index(o)) :
+                            -difference_type(block_index(-o - 1)) - 1;
+                        set_node(_node + n);
+                        _cur = (_last - BS) + (o - n * difference_type(BS));}
                     assert(valid());
                     return *this;}
 
@@ -501,120 +1202,827 @@ class my_deque {
                 // -----------
 
                 /**
-                 * -= the index of const iterator
+                 * -= the const iterator
                  */
                 const_iterator& operator -= (difference_type d) {
-                    _index -= d;
-                    assert(valid());
-                    return *this;}};
+                    return *this += -d;}};
 
     public:
-        // ------------
-        // constructors
-        // ------------
+        // -------
+        // segment
+        // -------
 
         /**
-         * default constructor
+         * a run of elements that sit next to each other in one block
          */
-        explicit my_deque (const allocator_type& a = allocator_type()) :
-                _a (a) {
-            _pa = std::allocator<T*>();
-            _cont = _pa.allocate(1);
-            _cont[0] = _a.allocate(10);
-            _b = _e = _cont[0];
-            _bi = _cbi = _cei = _ei = _cont;
-            _size = 0;
-            assert(valid());}
+        template <typename P>
+        struct basic_segment {
+            P         data;
+            size_type size;
 
-        /**
-         * returns a deque with s elements initialized to value v
-         */
-        explicit my_deque (size_type s, const_reference v = value_type(), const allocator_type& a = allocator_type()) :
-                _a (a) {
-            if(s == 0){
-                _pa = std::allocator<T*>();
-                _cont = _pa.allocate(1);
-                _cont[0] = _a.allocate(10);
-                _b = _e = _cont[0];
-                _bi = _cbi = _cei = _ei = _cont;
-                _size = 0;
-            }
-            else{
-               _pa = std::allocator<T*>();
-                size_type numBlocks = (s/10)*3;
-                if(numBlocks == 0){
-                    numBlocks = 3;
-                }
-                size_type halfBlock = numBlocks / 3;
-                _cont = _pa.allocate(numBlocks);
-                size_type i;
-                for(i = 0; i < numBlocks; ++i)
-                    _cont[i] = _a.allocate(10);
-
-                _cbi = _cont;
-                _bi = &_cont[halfBlock];
-                _b = _cont[halfBlock];
-                _cei = &_cont[numBlocks - 1];
-                _ei = &_cont[halfBlock + s/10];
-                _size = s;
-                _e = &*uninitialized_fill(_a, begin(), begin() + s, v) - 1;
-            }
-            assert(valid());}
+            P begin () const {
+                return data;}
 
-        /**
-         * (my_deque) constructor
-         */
-        my_deque (const my_deque& that) :
-                _a (that._a) {
-            _pa = std::allocator<T*>();
-            if(that._size == 0){
-                _cont = _pa.allocate(1);
-                _cont[0] = _a.allocate(10);
-                _b = _e = _cont[0];
-                _bi = _cbi = _cei = _ei = _cont;
-                _size = 0;
-            }
-            else{
-                size_type numBlocks = (that.size()-1)/10 +1;
-                _cont = _pa.allocate(numBlocks);
-                size_type i;
-                for(i = 0; i < numBlocks; ++i)
-                    _cont[i] = _a.allocate(10);
-
-                _bi = _cbi = _cont;
-                _b = _cont[0];
-                _e = _cont[numBlocks-1] + (that.size()-1)%10;
-                _cei = _ei = &_cont[numBlocks-1];
-                _size = that.size();
-                uninitialized_copy(_a, that.begin(), that.end(), begin());
-            }
-            assert(valid());}
+            P end () const {
+                return data + size;}};
 
-        // ----------
-        // destructor
-        // ----------
+        typedef basic_segment<pointer>       segment;
+        typedef basic_segment<const_pointer> const_segment;
+
+        // ----------------
+        // segment_iterator
+        // ----------------
 
         /**
-         * destructor of deque
+         * walks [b, e) one segment at a time
          */
-        ~my_deque () {
-            if (_b) {
-                clear();
-                iterator b = begin();
-                iterator e = end();
-
-                destroy (_a, b, e);
-
-                typename std::allocator<T*>::pointer index = _cbi;
-                size_type st = 10;
-                while(index <= _cei){
-                    _a.deallocate(*index,st);
-                    ++index;
-                }
-                st = _cei - _cbi;
-                _pa.deallocate(_cont, st);}
+        template <typename I, typename S>
+        class basic_segment_iterator {
+            public:
+                // --------
+                // typedefs
+                // --------
+
+                typedef std::forward_iterator_tag iterator_category;
+                typedef S                         value_type;
+                typedef std::ptrdiff_t            difference_type;
+                typedef const S*                  pointer;
+                typedef S                         reference;
+
+            public:
+                // -----------
+                // operator ==
+                // -----------
+
+                /**
+                 * returns true if the segment iterators start at the same element
+                 */
+                friend bool operator == (const basic_segment_iterator& lhs, const basic_segment_iterator& rhs) {
+                    return lhs._b == rhs._b;}
+
+                /**
+                 * returns false if the segment iterators start at the same element
+                 */
+                friend bool operator != (const basic_segment_iterator& lhs, const basic_segment_iterator& rhs) {
+                    return !(lhs == rhs);}
+
+            private:
+                // ----
+                // data
+                // ----
+
+                // first element of the current segment
+                I _b;
+
+                // end of the whole range
+                I _e;
+
+            public:
+                // -----------
+                // constructor
+                // -----------
+
+                /**
+                 * segment iterator at b over a range that ends at e
+                 */
+                basic_segment_iterator (I b, I e) :
+                        _b (b),
+                        _e (e)
+                    {}
+
+                // Default copy, destructor, and copy assignment.
+                // basic_segment_iterator (const basic_segment_iterator&);
+                // ~basic_segment_iterator ();
+                // basic_segment_iterator& operator = (const basic_segment_iterator&);
+
+                // ----------
+                // operator *
+                // ----------
+
+                /**
+                 * returns the current segment
+                 */
+                S operator * () const {
+                    S x = {&*_b, run_length(_b, _e - _b)};
+                    return x;}
+
+                // -----------
+                // operator ++
+                // -----------
+
+                /**
+                 * steps to the next segment
+                 */
+                basic_segment_iterator& operator ++ () {
+                    _b += run_length(_b, _e - _b);
+                    return *this;}
+
+                /**
+                 * steps to the next segment, post
+                 */
+                basic_segment_iterator operator ++ (int) {
+                    basic_segment_iterator x = *this;
+                    ++(*this);
+                    return x;}};
+
+        typedef basic_segment_iterator<iterator, segment>             segment_iterator;
+        typedef basic_segment_iterator<const_iterator, const_segment> const_segment_iterator;
+
+        // -------------
+        // segment_range
+        // -------------
+
+        /**
+         * the segments of [b, e), for range-based for loops
+         */
+        template <typename SI>
+        struct basic_segment_range {
+            SI _b;
+            SI _e;
+
+            SI begin () const {
+                return _b;}
+
+            SI end () const {
+                return _e;}};
+
+        typedef basic_segment_range<segment_iterator>       segment_range;
+        typedef basic_segment_range<const_segment_iterator> const_segment_range;
+
+    private:
+        // --------------
+        // initialize_map
+        // --------------
+
+        /**
+         * allocates a map with room for s elements plus slack on both sides
+         * and points _b and _e at an empty range in its middle third
+         * only the blocks that s elements land in, and the one ahead of them, get allocated
+         */
+        void initialize_map (size_type s) {
+            size_type needed    = block_index(s) + 1;
+            size_type numBlocks = needed * 3;
+            map_allocator_type pa = map_allocator();
+            _size = 0;
+            _cont = map_traits::allocate(pa, numBlocks);
+            std::fill(_cont, _cont + numBlocks, static_cast<T*>(0));
+            _cbi = _cont;
+            _cei = &_cont[numBlocks - 1];
+            try {
+                allocate_blocks(&_cont[needed - 1], &_cont[2 * needed]);}
+            catch (...) {
+                free_map();
+                null_map();
+                throw;}
+            _bi = _ei = &_cont[needed];
+            _b = _e = *_bi;}
+
+        // ---------------
+        // allocate_blocks
+        // ---------------
+
+        /**
+         * gives every map slot in [b, e) that has no block a fresh one
+         */
+        void allocate_blocks (T** b, T** e) {
+            for(; b != e; ++b)
+                if (!*b) {
+                    *b = traits::allocate(_a, BS);
+                    this->stat_allocate(_size, BS);}}
+
+        // -----------
+        // trim_blocks
+        // -----------
+
+        /**
+         * keeps at most _spare empty blocks at each end of the map, the block ahead of _bi always,
+         * and never fewer than a reserve still needs
+         * blocks drained past one end's cap move to the other end while it is short of its cap,
+         * so push_back reuses what pop_front drained, and the rest go back to the allocator
+         */
+        void trim_blocks () {
+            size_type keep  = std::max(std::max<size_type>(_spare, 1), reserved_front());
+            size_type spare = std::max(_spare, reserved_back());
+            T**       lo    = first_block();
+            T**       hi    = last_block();
+            size_type front = _bi - lo;
+            size_type back  = hi - _ei;
+            for(; (front > keep) && (back < spare) && (hi != _cei); --front, ++back, ++lo) {
+                *++hi = *lo;
+                *lo   = 0;}
+            for(; (back > spare) && (front < keep) && (lo != _cbi); --back, ++front, --hi) {
+                *--lo = *hi;
+                *hi   = 0;}
+            for(; front > keep; --front, ++lo) {
+                traits::deallocate(_a, *lo, BS);
+                this->stat_deallocate();
+                *lo = 0;}
+            for(; back > spare; --back, --hi) {
+                traits::deallocate(_a, *hi, BS);
+                this->stat_deallocate();
+                *hi = 0;}}
+
+        // --------------
+        // reserved_front
+        // --------------
+
+        /**
+         * the blocks ahead of _bi, the one kept for begin() - 1 included,
+         * that the pushes reserve_front promised still need
+         */
+        size_type reserved_front () const {
+            size_type c = _b - *_bi;
+            return (_reserve_front > c) ? block_index(_reserve_front - c - 1) + 2 : 1;}
+
+        // -------------
+        // reserved_back
+        // -------------
+
+        /**
+         * the blocks behind _ei that the pushes reserve_back promised still need
+         */
+        size_type reserved_back () const {
+            size_type c = BS - 1 - (_e - *_ei);
+            return (_reserve_back > c) ? block_index(_reserve_back - c - 1) + 1 : 0;}
+
+        // -----------
+        // first_block
+        // -----------
+
+        /**
+         * the outermost slot of the run of blocks ahead of _bi
+         * blocks are contiguous, so the walk stops at the first null slot
+         */
+        T** first_block () const {
+            T** i = _bi - 1;
+            while ((i != _cbi) && *(i - 1))
+                --i;
+            return i;}
+
+        // ----------
+        // last_block
+        // ----------
+
+        /**
+         * the outermost slot of the run of blocks from _ei on
+         */
+        T** last_block () const {
+            T** i = _ei;
+            while ((i != _cei) && *(i + 1))
+                ++i;
+            return i;}
+
+        // ----------
+        // take_front
+        // ----------
+
+        /**
+         * takes the outermost spare block ahead of the data, never the one ahead of _bi
+         * nor one that reserve_front set aside,
+         * so push_back uses a block the front has before it allocates one, returns 0 if there is none
+         */
+        T* take_front () {
+            T** lo = first_block();
+            if (size_type(_bi - lo) <= reserved_front())
+                return 0;
+            T* p = *lo;
+            *lo = 0;
+            return p;}
+
+        // ---------
+        // take_back
+        // ---------
+
+        /**
+         * takes the outermost spare block behind the data, never one that reserve_back set aside,
+         * so push_front uses a block the back has before it allocates one, returns 0 if there is none
+         */
+        T* take_back () {
+            T** hi = last_block();
+            if (size_type(hi - _ei) <= reserved_back())
+                return 0;
+            T* p = *hi;
+            *hi = 0;
+            return p;}
+
+        // ----------
+        // free_map
+        // ----------
+
+        /**
+         * gives every block and the map back to the allocators
+         * the elements must already be destroyed
+         */
+        void free_map () {
+            if (!_cont)
+                return;
+            for(T** i = _cbi; i <= _cei; ++i)
+                if (*i) {
+                    traits::deallocate(_a, *i, BS);
+                    this->stat_deallocate();}
+            map_allocator_type pa = map_allocator();
+            map_traits::deallocate(pa, _cont, _cei - _cbi + 1);}
+
+        // --------
+        // null_map
+        // --------
+
+        /**
+         * forgets the map, leaving an empty deque that owns no storage
+         */
+        void null_map () {
+            _cont = _cbi = _cei = _bi = _ei = 0;
+            _b = _e = 0;
+            _size = 0;
+            _reserve_front = _reserve_back = 0;}
+
+        // -----
+        // steal
+        // -----
+
+        /**
+         * takes over that's map and elements, leaving that with no storage
+         * this must not own a map
+         */
+        void steal (my_deque& that) {
+            _cont = that._cont;
+            _cbi  = that._cbi;
+            _cei  = that._cei;
+            _bi   = that._bi;
+            _ei   = that._ei;
+            _b    = that._b;
+            _e    = that._e;
+            _size = that._size;
+            _reserve_front = that._reserve_front;
+            _reserve_back  = that._reserve_back;
+            this->stat_take(that);
+            this->stat_peaks(_size, BS);
+            that.null_map();}
+
+        // --------------
+        // reallocate_map
+        // --------------
+
+        /**
+         * makes room for at least n more slots on each side of the slots in use
+         * slides the blocks back to the middle of the map when that is enough,
+         * otherwise grows the map, and the new slots stay empty until an element lands in them
+         */
+        void reallocate_map (size_type n) {
+            if (recenter_map(n))
+                return;
+            size_type wholeCap  = _cei - _cbi + 1;
+            size_type pad       = std::max(wholeCap, n);
+            size_type numBlocks = wholeCap + 2 * pad;
+            map_allocator_type pa = map_allocator();
+            T** newCont = map_traits::allocate(pa, numBlocks);
+            std::fill(newCont, newCont + pad, static_cast<T*>(0));
+            std::copy(_cont, _cont + wholeCap, newCont + pad);
+            this->stat_map(wholeCap * sizeof(T*));
+            std::fill(newCont + pad + wholeCap, newCont + numBlocks, static_cast<T*>(0));
+            _bi = newCont + pad + (_bi - _cbi);
+            _ei = newCont + pad + (_ei - _cbi);
+            map_traits::deallocate(pa, _cont, wholeCap);
+            _cont = _cbi = newCont;
+            _cei = &_cont[numBlocks - 1];
             assert(valid());}
 
+        // ------------
+        // recenter_map
+        // ------------
+
+        /**
+         * slides the run of blocks to the middle of the map if the map stays under half full
+         * with n more slots on each side, returns false if the map must grow instead
+         * a deque used as a FIFO creeps toward one end of its map, this brings it back without allocating
+         */
+        bool recenter_map (size_type n) {
+            size_type wholeCap = _cei - _cbi + 1;
+            T**       lo       = first_block();
+            T**       hi       = last_block() + 1;
+            size_type u        = hi - lo;
+            if (wholeCap <= 2 * (u + n))
+                return false;
+            T** to = _cbi + (wholeCap - u) / 2;
+            if (to < lo) {
+                std::copy(lo, hi, to);
+                std::fill(std::max(to + u, lo), hi, static_cast<T*>(0));}
+            else if (to > lo) {
+                std::copy_backward(lo, hi, to + u);
+                std::fill(lo, std::min(to, hi), static_cast<T*>(0));}
+            _bi += to - lo;
+            _ei += to - lo;
+            assert(valid());
+            return true;}
+
+        // ------------
+        // resize_front
+        // ------------
+
+        /**
+         * makes sure there are at least n blocks in the map ahead of _bi
+         */
+        void resize_front (size_type n) {
+            if (size_type(_bi - _cbi) < n)
+                reallocate_map(n);}
+
+        // -----------
+        // resize_back
+        // -----------
+
+        /**
+         * makes sure there are at least n blocks in the map behind _ei
+         */
+        void resize_back (size_type n) {
+            if (size_type(_cei - _ei) < n)
+                reallocate_map(n);}
+
+        // -------
+        // set_end
+        // -------
+
+        /**
+         * points _ei and _e at index s and makes s the size
+         */
+        void set_end (size_type s) {
+            if (s > _size)
+                _reserve_back -= std::min(_reserve_back, s - _size);
+            size_type o = (_b - *_bi) + s;
+            _ei = _bi + block_index(o);
+            _e = *_ei + block_offset(o);
+            _size = s;
+            this->stat_peaks(_size, BS);}
+
+        // -----------
+        // append_fill
+        // -----------
+
+        /**
+         * constructs n copies of v behind the last element, a block at a time
+         */
+        void append_fill (size_type n, const_reference v) {
+            if (n == 0)
+                return;
+            if (!_cont)
+                initialize_map(n);
+            resize_back(block_index((_e - *_ei) + n));
+            allocate_blocks(_ei, _ei + block_index((_e - *_ei) + n) + 1);
+            while (n != 0) {
+                size_type k = std::min<size_type>(n, BS - (_e - *_ei));
+                uninitialized_fill(_a, _e, _e + k, v);
+                set_end(_size + k);
+                n -= k;}}
+
+        // -----------
+        // append_copy
+        // -----------
+
+        /**
+         * copy constructs the n elements starting at b behind the last element
+         */
+        template <typename II>
+        void append_copy (II b, size_type n) {
+            if (n == 0)
+                return;
+            if (!_cont)
+                initialize_map(n);
+            resize_back(block_index((_e - *_ei) + n));
+            allocate_blocks(_ei, _ei + block_index((_e - *_ei) + n) + 1);
+            while (n != 0) {
+                size_type k = run_length(b, std::min<size_type>(n, BS - (_e - *_ei)));
+                construct_run(b, k, _e);
+                set_end(_size + k);
+                n -= k;}}
+
+        // ----------
+        // run_length
+        // ----------
+
+        /**
+         * how many of the next n elements from b sit in one contiguous run
+         */
+        template <typename II>
+        static size_type run_length (const II&, size_type n) {
+            return n;}
+
+        static size_type run_length (const iterator& b, size_type n) {
+            return std::min<size_type>(n, b._last - b._cur);}
+
+        static size_type run_length (const const_iterator& b, size_type n) {
+            return std::min<size_type>(n, b._last - b._cur);}
+
+        // -------------
+        // construct_run
+        // -------------
+
+        /**
+         * copy constructs the k elements starting at b into x and moves b past them
+         * runs out of a deque are handed over as pointers, so they get the memcpy path
+         */
+        template <typename II>
+        void construct_run (II& b, size_type k, pointer x) {
+            II m = b;
+            std::advance(m, k);
+            uninitialized_copy(_a, b, m, x);
+            b = m;}
+
+        void construct_run (iterator& b, size_type k, pointer x) {
+            uninitialized_copy(_a, b._cur, b._cur + k, x);
+            b += k;}
+
+        void construct_run (const_iterator& b, size_type k, pointer x) {
+            uninitialized_copy(_a, b._cur, b._cur + k, x);
+            b += k;}
+
+        // ---------
+        // copy_runs
+        // ---------
+
+        /**
+         * assigns the n elements starting at b to those starting at x
+         * a block-sized run at a time, so trivially copyable types get a memmove per run
+         */
+        template <typename SI>
+        static iterator copy_runs (SI b, size_type n, iterator x) {
+            while (n != 0) {
+                size_type k = run_length(b, run_length(x, n));
+                std::copy(b._cur, b._cur + k, x._cur);
+                b += k;
+                x += k;
+                n -= k;}
+            return x;}
+
+        // ---------
+        // move_runs
+        // ---------
+
+        /**
+         * moves [b, e) down onto the elements starting at x, front to back
+         * x must not come after b
+         */
+        static iterator move_runs (iterator b, iterator e, iterator x) {
+            size_type n = e - b;
+            while (n != 0) {
+                size_type k = run_length(b, run_length(x, n));
+                std::move(b._cur, b._cur + k, x._cur);
+                b += k;
+                x += k;
+                n -= k;}
+            return x;}
+
+        // ------------------
+        // move_backward_runs
+        // ------------------
+
+        /**
+         * moves [b, e) up onto the elements ending at x, back to front
+         * x must not come before e
+         */
+        static iterator move_backward_runs (iterator b, iterator e, iterator x) {
+            size_type n = e - b;
+            while (n != 0) {
+                pointer   ep = e._cur;
+                size_type el = ep - (e._last - BS);
+                if (el == 0) {
+                    ep = *(e._node - 1) + BS;
+                    el = BS;}
+                pointer   xp = x._cur;
+                size_type xl = xp - (x._last - BS);
+                if (xl == 0) {
+                    xp = *(x._node - 1) + BS;
+                    xl = BS;}
+                size_type k = std::min(n, std::min(el, xl));
+                std::move_backward(ep - k, ep, xp);
+                e -= k;
+                x -= k;
+                n -= k;}
+            return x;}
+
+        // ------------
+        // prepend_copy
+        // ------------
+
+        /**
+         * copy constructs the n elements starting at b ahead of the first element
+         * grows the map once and fills whole blocks front to back
+         */
+        template <typename II>
+        void prepend_copy (II b, size_type n) {
+            if (n == 0)
+                return;
+            if (!_cont)
+                initialize_map(0);
+            size_type off = _b - *_bi;
+            size_type k   = (n > off) ? block_index(n - off - 1) + 1 : 0;
+            resize_front(k + 1);
+            allocate_blocks(_bi - k - 1, _bi);
+            T**     nbi = _bi - k;
+            pointer nb  = *nbi + ((k * BS + off) - n);
+            T**     i   = nbi;
+            pointer p   = nb;
+            size_type done = 0;
+            try {
+                while (true) {
+                    size_type c = run_length(b, std::min<size_type>(n - done, (*i + BS) - p));
+                    construct_run(b, c, p);
+                    p += c;
+                    done += c;
+                    if (done == n)
+                        break;
+                    if (p == *i + BS) {
+                        ++i;
+                        p = *i;}}}
+            catch (...) {
+                destroy(_a, iterator(nb, nbi), iterator(p, i));
+                throw;}
+            _bi = nbi;
+            _b  = nb;
+            _size += n;
+            _reserve_front -= std::min(_reserve_front, n);
+            this->stat_peaks(_size, BS);}
+
+        // ------------
+        // append_range
+        // ------------
+
+        /**
+         * appends [b, e) one element at a time, its length is unknown
+         */
+        template <typename II>
+        void append_range (II b, II e, std::input_iterator_tag) {
+            for(; b != e; ++b)
+                emplace_back(*b);}
+
+        /**
+         * appends [b, e) a block at a time, reserving once
+         */
+        template <typename FI>
+        void append_range (FI b, FI e, std::forward_iterator_tag) {
+            append_copy(b, std::distance(b, e));}
+
+        // -------------
+        // prepend_range
+        // -------------
+
+        /**
+         * prepends [b, e) one element at a time and restores its order
+         */
+        template <typename II>
+        void prepend_range (II b, II e, std::input_iterator_tag) {
+            size_type n = 0;
+            for(; b != e; ++b, ++n)
+                emplace_front(*b);
+            std::reverse(begin(), begin() + n);}
+
+        /**
+         * prepends [b, e) a block at a time, reserving once
+         */
+        template <typename FI>
+        void prepend_range (FI b, FI e, std::forward_iterator_tag) {
+            prepend_copy(b, std::distance(b, e));}
+
+        // ------------
+        // assign_range
+        // ------------
+
+        /**
+         * replaces the elements with [b, e), its length is unknown
+         */
+        template <typename II>
+        void assign_range (II b, II e, std::input_iterator_tag) {
+            clear();
+            append_range(b, e, std::input_iterator_tag());}
+
+        /**
+         * replaces the elements with [b, e), reusing the elements already there
+         */
+        template <typename FI>
+        void assign_range (FI b, FI e, std::forward_iterator_tag) {
+            size_type n = std::distance(b, e);
+            if (n <= size()) {
+                std::copy(b, e, begin());
+                resize(n);}
+            else {
+                FI m = b;
+                std::advance(m, size());
+                std::copy(b, m, begin());
+                append_copy(m, n - size());}}
+
+        // -----------
+        // move_assign
+        // -----------
+
+        /**
+         * the allocators propagate or are equal, so rhs's blocks can be taken over
+         */
+        void move_assign (my_deque& rhs, std::true_type) {
+            destroy(_a, begin(), end());
+            free_map();
+            null_map();
+            deque_move_allocator(_a, rhs._a, typename traits::propagate_on_container_move_assignment());
+            steal(rhs);}
+
+        /**
+         * rhs's blocks may belong to another arena, so unless the allocators are equal
+         * the elements move one at a time into blocks from _a
+         */
+        void move_assign (my_deque& rhs, std::false_type) {
+            if (_a == rhs._a) {
+                move_assign(rhs, std::true_type());
+                return;}
+            assign(std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
+            rhs.clear();}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * default constructor
+         * allocates nothing, the map and the first blocks come with the first element
+         */
+        my_deque () noexcept(noexcept(allocator_type())) :
+                _a     (),
+                _spare (default_spare_blocks) {
+            null_map();
+            assert(valid());}
+
+        /**
+         * an empty deque that will allocate from a, allocates nothing yet
+         */
+        explicit my_deque (const allocator_type& a) noexcept :
+                _a     (a),
+                _spare (default_spare_blocks) {
+            null_map();
+            assert(valid());}
+
+        /**
+         * returns a deque with s elements initialized to value v
+         */
+        explicit my_deque (size_type s, const_reference v = value_type(), const allocator_type& a = allocator_type()) :
+                _a     (a),
+                _spare (default_spare_blocks) {
+            null_map();
+            try {
+                append_fill(s, v);}
+            catch (...) {
+                destroy(_a, begin(), end());
+                free_map();
+                throw;}
+            assert(valid());}
+
+        /**
+         * returns a deque holding a copy of [b, e)
+         */
+        template <typename II, typename = typename std::iterator_traits<II>::iterator_category>
+        my_deque (II b, II e, const allocator_type& a = allocator_type()) :
+                _a     (a),
+                _spare (default_spare_blocks) {
+            null_map();
+            try {
+                append(b, e);}
+            catch (...) {
+                destroy(_a, begin(), end());
+                free_map();
+                throw;}
+            assert(valid());}
+
+        /**
+         * (my_deque) constructor
+         */
+        my_deque (const my_deque& that) :
+                _a     (traits::select_on_container_copy_construction(that._a)),
+                _spare (that._spare) {
+            null_map();
+            try {
+                append_copy(that.begin(), that.size());}
+            catch (...) {
+                destroy(_a, begin(), end());
+                free_map();
+                throw;}
+            assert(valid());}
+
+        /**
+         * (my_deque&&) constructor
+         * takes over that's blocks, leaving that empty
+         */
+        my_deque (my_deque&& that) noexcept :
+                _a     (std::move(that._a)),
+                _spare (that._spare) {
+            steal(that);
+            assert(valid());}
+
+        // ----------
+        // destructor
+        // ----------
+
+        /**
+         * destructor of deque
+         */
+        ~my_deque () {
+            destroy(_a, begin(), end());
+            free_map();}
 
         // ----------
         // operator =
@@ -624,43 +2032,35 @@ class my_deque {
          * sets this deque equal to the right hand deque
          */
         my_deque& operator = (const my_deque& rhs) {
-            size_type capacity = _cei-_cbi;
             if (this == &rhs)
                 return *this;
-            if (rhs.size() == size())
-                std::copy(rhs.begin(), rhs.end(), begin());
-            else if (rhs.size() < size()) {
-                std::copy(rhs.begin(), rhs.end(), begin());
+            if (traits::propagate_on_container_copy_assignment::value && !(_a == rhs._a)) {
+                // the blocks must go back to the allocator that gave them out
+                destroy(_a, begin(), end());
+                free_map();
+                null_map();}
+            deque_copy_allocator(_a, rhs._a, typename traits::propagate_on_container_copy_assignment());
+            if (rhs.size() <= size()) {
+                copy_runs(rhs.begin(), rhs.size(), begin());
                 resize(rhs.size());}
-            else if (rhs.size() <= ((capacity+1)*10)) {
-                if(_size == 1){
-                    std::copy(rhs.begin(), rhs.begin() + 1, begin());
-                    _e = &*uninitialized_copy(_a, rhs.begin()+1, rhs.end(), end()) - 1;
-
-                }else{
-                    std::copy(rhs.begin(), rhs.begin() + size(), begin());
-                     _e = &*uninitialized_copy(_a, rhs.begin() + size(), rhs.end(), end()) - 1;
-
-                }
-                _size = rhs.size();
-            }
             else {
-                clear();
-                size_type numBlocks = (rhs.size()-1)/10 +1;
-                _cont = _pa.allocate(numBlocks);
-                size_type i;
-                for(i = 0; i < numBlocks; ++i)
-                    _cont[i] = _a.allocate(10);
-                _bi = _cbi = _cont;
-                _b = _cont[0];
-                _e = _cont[numBlocks-1] + (rhs.size()-1)%10;
-                _cei = _ei = &_cont[numBlocks-1];
-                _size = rhs.size();
-                _e = &*uninitialized_copy(_a, rhs.begin(), rhs.end(), begin()) - 1;}
+                copy_runs(rhs.begin(), size(), begin());
+                append_copy(rhs.begin() + size(), rhs.size() - size());}
             assert(valid());
-            return *this;
-        }
+            return *this;}
 
+        /**
+         * takes over the right hand deque's blocks, leaving it empty
+         * if the allocators neither propagate nor compare equal, moves the elements instead
+         */
+        my_deque& operator = (my_deque&& rhs)
+                noexcept(traits::propagate_on_container_move_assignment::value || traits::is_always_equal::value) {
+            if (this == &rhs)
+                return *this;
+            move_assign(rhs, std::integral_constant<bool,
+                traits::propagate_on_container_move_assignment::value || traits::is_always_equal::value>());
+            assert(valid());
+            return *this;}
 
         // -----------
         // operator []
@@ -670,14 +2070,8 @@ class my_deque {
          * returns ref to element at index
          */
         reference operator [] (size_type index) {
-         
-            if(_b + index < *_bi + 10)
-                return *(_b + index);
-            else{
-                size_type temp = _bi - _cbi;
-                int offs = 10 - (_b - *_bi);
-                index -= offs;
-                return _cont[temp + index/10 + 1][index%10];}}
+            size_type o = (_b - *_bi) + index;
+            return _bi[block_index(o)][block_offset(o)];}
 
         /**
          * returns const ref to element at index
@@ -704,18 +2098,81 @@ class my_deque {
             return const_cast<my_deque*>(this)->at(index);}
 
 
+        // ------
+        // append
+        // ------
+
+        /**
+         * adds a copy of [b, e) behind the last element
+         */
+        template <typename II>
+        void append (II b, II e) {
+            append_range(b, e, typename std::iterator_traits<II>::iterator_category());
+            assert(valid());}
+
+        // -----------
+        // append_from
+        // -----------
+
+        /**
+         * reads up to n elements in the binary layout of T from in, straight into blocks behind the last element
+         * one read per block, returns the number read, which is short only at the end of in
+         * n may come from an untrusted header, so the next block is only taken once a read has filled the last one
+         * T must be trivially copyable
+         */
+        size_type append_from (std::istream& in, size_type n) {
+            static_assert(std::is_trivially_copyable<T>::value, "my_deque::append_from: T must be trivially copyable");
+            if (n == 0)
+                return 0;
+            if (!_cont)
+                initialize_map(0);
+            size_type r = 0;
+            while (n != 0) {
+                size_type k = std::min<size_type>(n, BS - (_e - *_ei));
+                in.read(reinterpret_cast<char*>(_e), k * sizeof(T));
+                size_type got = size_type(in.gcount()) / sizeof(T);
+                if (_e + got == *_ei + BS) {
+                    // the end moves into the next block
+                    resize_back(1);
+                    if (!*(_ei + 1))
+                        *(_ei + 1) = take_front();
+                    allocate_blocks(_ei + 1, _ei + 2);}
+                set_end(_size + got);
+                r += got;
+                if (got != k)
+                    break;
+                n -= k;}
+            trim_blocks();
+            assert(valid());
+            return r;}
+
+        // ------
+        // assign
+        // ------
+
+        /**
+         * replaces the elements with a copy of [b, e)
+         */
+        template <typename II>
+        void assign (II b, II e) {
+            assign_range(b, e, typename std::iterator_traits<II>::iterator_category());
+            assert(valid());}
+
         // ----
         // back
         // ----
 
         /**
-         * <returns an iterator pointing to the end of the deque
+         * returns the last element
          */
         reference back () {
-            return (*this)[size()-1];}
+            assert(!empty());
+            if (_e == *_ei)
+                return *(*(_ei - 1) + (BS - 1));
+            return *(_e - 1);}
 
         /**
-         * returns a const iterator pointing to the end of the deque
+         * returns the const last element
          */
         const_reference back () const {
             return const_cast<my_deque*>(this)->back();}
@@ -728,13 +2185,41 @@ class my_deque {
          * returns an iterator pointing to the beginning of the deque
          */
         iterator begin () {
-            return iterator(this,0);}
+            return iterator(_b, _bi);}
 
         /**
          * returns a const iterator pointing to the beginning of the deque
          */
         const_iterator begin () const {
-            return const_iterator(const_cast<my_deque*>(this),0);}
+            return const_iterator(_b, _bi);}
+
+        // --------
+        // capacity
+        // --------
+
+        /**
+         * returns how many elements push_back can add with the blocks already at that end
+         */
+        size_type capacity_back () const {
+            if (!_cont)
+                return 0;
+            size_type k = 0;
+            for(T** i = _ei + 1; (i <= _cei) && *i; ++i)
+                ++k;
+            // a push into the last slot of a block needs the next block
+            return (BS - 1 - (_e - *_ei)) + k * BS;}
+
+        /**
+         * returns how many elements push_front can add with the blocks already at that end
+         */
+        size_type capacity_front () const {
+            if (!_cont)
+                return 0;
+            size_type k = 0;
+            for(T** i = _bi - 1; (i >= _cbi) && *i; --i)
+                ++k;
+            // the block ahead of _bi never takes elements, it is kept for begin() - 1
+            return (_b - *_bi) + (k - 1) * BS;}
 
         // -----
         // clear
@@ -744,9 +2229,43 @@ class my_deque {
          * removes all elements in the deque
          */
         void clear () {
-	    resize(0);            
+	    resize(0);
             assert(valid());}
 
+        // -----------
+        // deserialize
+        // -----------
+
+        /**
+         * replaces the elements with those written to in by serialize
+         * the elements are read block by block into fresh blocks, the deque is unchanged if that fails
+         * throws std::runtime_error if in does not hold a whole my_deque of this T
+         */
+        void deserialize (std::istream& in) {
+            deque_binary_header h = deque_binary_header::read(in, sizeof(T));
+            my_deque x(_a);
+            x._spare = _spare;
+            if (x.append_from(in, size_type(h.count)) != h.count)
+                throw std::runtime_error("my_deque::deserialize: truncated stream");
+            swap(x);}
+
+        // -----------
+        // drain_front
+        // -----------
+
+        /**
+         * moves the first min(n, size()) elements to x, a block-sized run at a time,
+         * then removes them as pop_front_n does
+         * returns x past the last element moved
+         */
+        template <typename OI>
+        OI drain_front (size_type n, OI x) {
+            n = std::min(n, size());
+            for (segment s : segments(begin(), begin() + n))
+                x = std::move(s.data, s.data + s.size, x);
+            pop_front_n(n);
+            return x;}
+
         // -----
         // empty
         // -----
@@ -757,21 +2276,99 @@ class my_deque {
         bool empty () const {
             return !size();}
 
+        // -------
+        // emplace
+        // -------
+
+        /**
+         * constructs an element from args at position i
+         * shifts whichever side of i is shorter
+         */
+        template <typename... Args>
+        iterator emplace (iterator i, Args&&... args) {
+            if(i == begin()){
+                emplace_front(std::forward<Args>(args)...);
+                return begin();}
+            if(i == end()){
+                emplace_back(std::forward<Args>(args)...);
+                return end() - 1;}
+            difference_type index = i - begin();
+            value_type x(std::forward<Args>(args)...);
+            if(size_type(index) < size() / 2){
+                this->stat_shift(index);
+                emplace_front(std::move(front()));
+                move_runs(begin() + 2, begin() + (index + 1), begin() + 1);}
+            else{
+                this->stat_shift(size() - index);
+                emplace_back(std::move(back()));
+                move_backward_runs(begin() + index, end() - 2, end() - 1);}
+            i = begin() + index;
+            *i = std::move(x);
+            assert(valid());
+            return i;}
+
+        /**
+         * constructs an element from args behind the last element
+         */
+        template <typename... Args>
+        void emplace_back (Args&&... args) {
+            if (!_cont)
+                initialize_map(0);
+            if (_e == *_ei + (BS - 1)) {
+                resize_back(1);
+                if (!*(_ei + 1))
+                    *(_ei + 1) = take_front();
+                allocate_blocks(_ei + 1, _ei + 2);}
+            traits::construct(_a, _e, std::forward<Args>(args)...);
+            if (_e == *_ei + (BS - 1)) {
+                ++_ei;
+                _e = *_ei;}
+            else
+                ++_e;
+            ++_size;
+            _reserve_back -= (_reserve_back != 0);
+            this->stat_peaks(_size, BS);
+            assert(valid());}
+
+        /**
+         * constructs an element from args ahead of the first element
+         */
+        template <typename... Args>
+        void emplace_front (Args&&... args) {
+            if (!_cont)
+                initialize_map(0);
+            if (_b == *_bi) {
+                // keep a block ahead of _bi so stepping back from begin() stays in the map
+                resize_front(2);
+                if (!*(_bi - 2))
+                    *(_bi - 2) = take_back();
+                allocate_blocks(_bi - 2, _bi - 1);
+                traits::construct(_a, *(_bi - 1) + (BS - 1), std::forward<Args>(args)...);
+                --_bi;
+                _b = *_bi + (BS - 1);}
+            else {
+                traits::construct(_a, _b - 1, std::forward<Args>(args)...);
+                --_b;}
+            ++_size;
+            _reserve_front -= (_reserve_front != 0);
+            this->stat_peaks(_size, BS);
+            assert(valid());}
+
         // ---
         // end
         // ---
 
         /**
-         * returns the last element
+         * returns an iterator one past the last element
          */
         iterator end () {
-            return iterator(this,_size);}
+            return iterator(_e, _ei);}
 
         /**
-         * return const last element
+         * returns a const iterator one past the last element
          */
         const_iterator end () const {
-            return const_iterator(this,_size);}
+            return const_iterator(_e, _ei);}
 
         // -----
         // erase
@@ -779,32 +2376,63 @@ class my_deque {
 
         /**
          * removes an the element pointed to by the iterator
+         * shifts whichever side of it is shorter
          */
         iterator erase (iterator it) {
             if(it == begin()){
-                destroy(_a,begin(),begin()+1);
-                --_size;
-                if(*_bi+9 == _b){
-                    ++_bi;
-                    _b = *_bi;
-                }else{
-                ++_b;
-                }
-             }else{
-            while(it != end() - 1){
-		        *it = *(it+1);
-                ++it;}
-	        destroy(_a,end()-1,end());
-            --_e;
-            if(_e < *_ei){
-                --_ei;
-                _e = *_ei + 9;}
-	        --_size;
-        }
+                pop_front();
+                return begin();}
+            difference_type index = it - begin();
+            if(size_type(index) < size() / 2){
+                this->stat_shift(index);
+                move_backward_runs(begin(), it, it + 1);
+                pop_front();}
+            else{
+                this->stat_shift(size() - index - 1);
+                move_runs(it + 1, end(), it);
+                pop_back();}
             assert(valid());
-            return it;
+            return begin() + index;}
 
-        }
+        // ----------------
+        // for_each_segment
+        // ----------------
+
+        /**
+         * calls f(p, n) on each run of n contiguous elements starting at p, front to back
+         */
+        template <typename F>
+        F for_each_segment (F f) {
+            return for_each_segment(begin(), end(), f);}
+
+        /**
+         * calls f(p, n) on each run of contiguous elements of [b, e)
+         */
+        template <typename F>
+        F for_each_segment (iterator b, iterator e, F f) {
+            while (b != e) {
+                size_type k = run_length(b, e - b);
+                f(&*b, k);
+                b += k;}
+            return f;}
+
+        /**
+         * calls f(p, n) on each run of contiguous const elements, front to back
+         */
+        template <typename F>
+        F for_each_segment (F f) const {
+            return for_each_segment(begin(), end(), f);}
+
+        /**
+         * calls f(p, n) on each run of contiguous const elements of [b, e)
+         */
+        template <typename F>
+        F for_each_segment (const_iterator b, const_iterator e, F f) const {
+            while (b != e) {
+                size_type k = run_length(b, e - b);
+                f(&*b, k);
+                b += k;}
+            return f;}
 
         // -----
         // front
@@ -814,7 +2442,8 @@ class my_deque {
          * returns the first element
          */
         reference front () {
-            return (*this)[0];}
+            assert(!empty());
+            return *_b;}
 
         /**
          * return const first element
@@ -822,6 +2451,16 @@ class my_deque {
         const_reference front () const {
             return const_cast<my_deque*>(this)->front();}
 
+        // -------------
+        // get_allocator
+        // -------------
+
+        /**
+         * returns a copy of the allocator the blocks and the map come from
+         */
+        allocator_type get_allocator () const {
+            return _a;}
+
         // ------
         // insert
         // ------
@@ -830,50 +2469,33 @@ class my_deque {
          * inserts a value at the ith position in the deque
          */
         iterator insert (iterator i, const_reference v) {
+            return emplace(i, v);}
 
-            if(empty()){          
-              *_b = v;
-                _size = 1;
-            } else if(i == begin()){
-                if(_b == *_bi){
-                    resize_front(size());
-                    --i;
-                    ++_size;
-                    --_bi;
-                    _b = *_bi+9;
-                    *_b = v;
-                }
-                else{
-                    --i;
-                    ++_size;
-                    --_b;
-                    *_b = v;
-                }
-            }else if(i == end()){
-                resize(size()+1,v);
-            }
+        /**
+         * moves a value into the ith position in the deque
+         */
+        iterator insert (iterator i, value_type&& v) {
+            return emplace(i, std::move(v));}
+
+        /**
+         * inserts a copy of [b, e) at the ith position in the deque
+         * the range is added at the nearer end and rotated into place
+         */
+        template <typename II, typename = typename std::iterator_traits<II>::iterator_category>
+        iterator insert (iterator i, II b, II e) {
+            difference_type index = i - begin();
+            size_type s = size();
+            if(size_type(index) < s / 2){
+                prepend(b, e);
+                difference_type n = size() - s;
+                this->stat_shift(index);
+                std::rotate(begin(), begin() + n, begin() + (n + index));}
             else{
-        	     iterator it = end() - 1;
-                 if(i == end() - 1){
-                    it = end();
-                    *it = *i;
-                    *i = v;
-                 }else{
-            	     while(it != i){
-                		*it = *(it-1);
-                        --it;
-                    }
-                	*it = v;
-                    ++_e;
-                }
-                if(_e == *_ei + 10){
-                    ++_ei;
-                    _e = *_ei;
-                }
-                ++_size;
-            }
-        assert(valid());
-        return i;}
+                append(b, e);
+                this->stat_shift(s - index);
+                std::rotate(begin() + index, begin() + s, end());}
+            assert(valid());
+            return begin() + index;}
 
         // ---
         // pop
@@ -884,7 +2506,13 @@ class my_deque {
          */
         void pop_back () {
             assert(!empty());
-	    resize(size() - 1);
+            if (_e == *_ei) {
+                --_ei;
+                _e = *_ei + BS;
+                trim_blocks();}
+            --_e;
+            traits::destroy(_a, _e);
+            --_size;
             assert(valid());}
 
         /**
@@ -892,7 +2520,61 @@ class my_deque {
          */
         void pop_front () {
             assert(!empty());
-            erase(begin());
+            traits::destroy(_a, _b);
+            if (_b == *_bi + (BS - 1)) {
+                ++_bi;
+                _b = *_bi;
+                trim_blocks();}
+            else
+                ++_b;
+            --_size;
+            assert(valid());}
+
+        /**
+         * removes the last min(n, size()) elements, destroying them a block at a time
+         * and giving back the emptied blocks beyond the spares in one pass
+         * returns the number removed
+         */
+        size_type pop_back_n (size_type n) {
+            n = std::min(n, size());
+            if (n == 0)
+                return 0;
+            for (segment x : segments(end() - n, end()))
+                destroy(_a, x.data, x.data + x.size);
+            set_end(_size - n);
+            trim_blocks();
+            assert(valid());
+            return n;}
+
+        /**
+         * removes the first min(n, size()) elements, destroying them a block at a time
+         * and giving back the emptied blocks beyond the spares in one pass
+         * returns the number removed
+         */
+        size_type pop_front_n (size_type n) {
+            n = std::min(n, size());
+            if (n == 0)
+                return 0;
+            for (segment x : segments(begin(), begin() + n))
+                destroy(_a, x.data, x.data + x.size);
+            size_type o = (_b - *_bi) + n;
+            _bi += block_index(o);
+            _b   = *_bi + block_offset(o);
+            _size -= n;
+            trim_blocks();
+            assert(valid());
+            return n;}
+
+        // -------
+        // prepend
+        // -------
+
+        /**
+         * adds a copy of [b, e) ahead of the first element, keeping its order
+         */
+        template <typename II>
+        void prepend (II b, II e) {
+            prepend_range(b, e, typename std::iterator_traits<II>::iterator_category());
             assert(valid());}
 
         // ----
@@ -903,18 +2585,25 @@ class my_deque {
          * adds element to back
          */
         void push_back (const_reference v) {
-            if(_cei - _ei == 0)
-	        resize(size() + 1, v);
-	    else
-		insert(end(),v);
-            assert(valid());}
+            emplace_back(v);}
+
+        /**
+         * moves element to back
+         */
+        void push_back (value_type&& v) {
+            emplace_back(std::move(v));}
 
         /**
          * adds element to front
          */
         void push_front (const_reference v) {
-            insert(begin(), v);
-            assert(valid());}
+            emplace_front(v);}
+
+        /**
+         * moves element to front
+         */
+        void push_front (value_type&& v) {
+            emplace_front(std::move(v));}
 
 
         // ----
@@ -923,49 +2612,57 @@ class my_deque {
 
         /**
          * gives great visual of the current state of the deque
+         * one line per block, 0 for slots that hold no element
          */
-
          void print_deque(){
-            size_type s = _cei - _cbi;
-            size_type i = 0;
-            size_type offs = 0;
-            size_type index = 0;
-            for(i = 0; i < s; ++i){
-
-                size_type x;
-                for(x = 0; x < 10; ++x){
-                    offs = x;
-                    if(&_cont[i][x] == _b) break;
-                    cout << 0;
-                }
-                index = i;
-                if(&_cont[i][x] == _b) break;
-                cout << endl;
-            }
-
-            iterator b = begin();
-            iterator e = end();
-
-            while(b!=e){
-                cout << *b;
-                ++offs;
-                if(offs % 10 == 0){
-                    cout << endl;
-                    ++index; 
-                }
-                ++b;
-            }
-
-            offs %= 10;
-            for(i = index; i <= s; ++i){
-
-                size_type x;
-                for(x = offs; x < 10; ++x){
-                    cout << 0;
-                }
-                offs = 0;
+            if(!_cont)
+                return;
+            for(T** i = _cbi; i <= _cei; ++i){
+                for(size_type x = 0; x < BS; ++x){
+                    pointer p = *i ? *i + x : 0;
+                    bool used = p && (i >= _bi) && (i <= _ei) &&
+                                ((i != _bi) || (p >= _b)) && ((i != _ei) || (p < _e));
+                    if(used)
+                        cout << *p;
+                    else
+                        cout << 0;}
                 cout << endl;}}
 
+        // -------
+        // reserve
+        // -------
+
+        /**
+         * allocates the blocks and map slots so that the next n calls to push_back do not allocate
+         * the blocks stay set aside through pops at either end and pushes at the front,
+         * and are released one by one as push_back fills them or by shrink_to_fit
+         */
+        void reserve_back (size_type n) {
+            if (!_cont)
+                initialize_map(0);
+            _reserve_back = n;
+            size_type k = reserved_back();
+            if (k != 0) {
+                resize_back(k);
+                allocate_blocks(_ei + 1, _ei + k + 1);}
+            assert(capacity_back() >= n);
+            assert(valid());}
+
+        /**
+         * allocates the blocks and map slots so that the next n calls to push_front do not allocate
+         * the blocks stay set aside through pops at either end and pushes at the back,
+         * and are released one by one as push_front fills them or by shrink_to_fit
+         */
+        void reserve_front (size_type n) {
+            if (!_cont)
+                initialize_map(0);
+            _reserve_front = n;
+            size_type k = reserved_front();
+            resize_front(k);
+            allocate_blocks(_bi - k, _bi);
+            assert(capacity_front() >= n);
+            assert(valid());}
+
         // ------
         // resize
         // ------
@@ -974,98 +2671,95 @@ class my_deque {
          * sets the number of elements in the deque and adds capacity if needed
          */
         void resize (size_type s, const_reference v = value_type()) {
-            size_type wholeCap = _cei - _cbi + 1;
-            size_type endCap = _cei - _ei;
-            size_type from_EIto_BI = _ei - _bi;
-            size_type temp = (10*endCap + (9-(_e - *_ei)));
-            T** i;
             if(s == _size)
                 return;
             if(s < _size) {
-                _e = &*destroy(_a, begin() + s, end());
-                for(i = _cont + 0; i < _cei; ++i)
-                    if((_e - *i) >= 0 && (_e - *i) <= 9) break;
-                _ei = i;
-                _size = s;
-            }
-            else if(_ei != 0 && (s - _size <  temp)){
-                size_type endTemp = _size;
-                _size = s;
-                if(_e == *_ei+8){
-                 _e = &*uninitialized_fill(_a, iterator(this,endTemp), end(), v);
-                }
-                else{
-                _e = &*uninitialized_fill(_a, iterator(this,endTemp), end(), v) - 1;
-                }
-                for(i = _bi; i <= _cei; ++i){
-                    if((_e - *i) >= 0 && (_e - *i) <= 9){
-                        break;}}
-                 _ei = i;
-
-            } else{
-                T** newCont;
-                _pa = std::allocator<T*>();
-                size_type numBlocks = wholeCap*3;
-                if(numBlocks == 0)
-                    numBlocks = s*3;
-                size_type halfBlock = numBlocks/3;
-                newCont = _pa.allocate(numBlocks);
-                size_type ind;
-                size_type counter = 0;
-                for(ind = 0; ind < numBlocks; ++ind){
-                    if(_cei != 0 && (ind >= halfBlock) && (ind < halfBlock + wholeCap)){
-                        newCont[ind] = _cont[counter];
-                        ++counter;
-                    }
-                    else{
-                        newCont[ind] = _a.allocate(10);}}
-                size_type tempo = (_bi - _cbi);
-                _bi = &newCont[halfBlock + tempo];
-                _ei = &newCont[halfBlock + from_EIto_BI + tempo];
-                if(counter == 0){
-                    _b = _e = *_bi;
-                }
-                if(wholeCap != 0)
-                    _pa.deallocate(_cont,wholeCap);
-                _cont = newCont;   
-                _cbi = _cont;
-                _cei = &_cont[numBlocks-1];
-                resize(s,v);
-            }
-            
+                destroy(_a, begin() + s, end());
+                set_end(s);
+                trim_blocks();}
+            else
+                append_fill(s - _size, v);
             assert(valid());}
 
-            void resize_front (size_type s) {
-                size_type from_EIto_BI = _ei - _bi;
-                T** newCont;
-                _pa = std::allocator<T*>();
-                size_type wholeCap = _cei - _cbi + 1;
-                size_type numBlocks = wholeCap*3;
-                size_type halfBlock = numBlocks/3;
-                newCont = _pa.allocate(numBlocks);
-                size_type ind;
-                size_type counter = 0;
-                for(ind = 0; ind < numBlocks; ++ind){
-                    if(_cei != 0 && (ind >= halfBlock) && (ind < halfBlock + wholeCap)){
-                        newCont[ind] = _cont[counter];
-                        ++counter;
-                    }
-                    else{
-                        newCont[ind] = _a.allocate(10);
-                    }
-                }
-                size_type tempo = (_bi - _cbi);
-                _bi = &newCont[halfBlock + tempo];
-                _ei = &newCont[halfBlock + from_EIto_BI + tempo];
-                if(counter == 0){
-                    _b = _e = *_bi;
-                }
-                if(wholeCap != 0)
-                    _pa.deallocate(_cont,wholeCap);
-                _cont = newCont;   
-                _cbi = _cont;
-                _cei = &_cont[numBlocks-1];
-                assert(valid());}
+        // --------
+        // segments
+        // --------
+
+        /**
+         * returns the segments of the whole deque
+         */
+        segment_range segments () {
+            return segments(begin(), end());}
+
+        /**
+         * returns the segments of [b, e)
+         */
+        segment_range segments (iterator b, iterator e) {
+            segment_range x = {segment_iterator(b, e), segment_iterator(e, e)};
+            return x;}
+
+        /**
+         * returns the const segments of the whole deque
+         */
+        const_segment_range segments () const {
+            return segments(begin(), end());}
+
+        /**
+         * returns the const segments of [b, e)
+         */
+        const_segment_range segments (const_iterator b, const_iterator e) const {
+            const_segment_range x = {const_segment_iterator(b, e), const_segment_iterator(e, e)};
+            return x;}
+
+        // ---------
+        // serialize
+        // ---------
+
+        /**
+         * writes the deque to out in the binary format read by deserialize:
+         * a deque_binary_header, then the elements, one write per block
+         * failures show in the state of out, as with operator <<
+         * T must be trivially copyable
+         */
+        void serialize (std::ostream& out) const {
+            static_assert(std::is_trivially_copyable<T>::value, "my_deque::serialize: T must be trivially copyable");
+            deque_binary_header h;
+            h.element_size = sizeof(T);
+            h.count        = size();
+            h.write(out);
+            for (const_segment x : segments())
+                out.write(reinterpret_cast<const char*>(x.data), x.size * sizeof(T));}
+
+        // -------------
+        // shrink_to_fit
+        // -------------
+
+        /**
+         * gives back every empty block, reserved ones included, and shrinks the map to the blocks in use
+         * an empty deque gives back all of its storage
+         */
+        void shrink_to_fit () {
+            if (!_cont)
+                return;
+            _reserve_front = _reserve_back = 0;
+            if (empty()) {
+                free_map();
+                null_map();
+                return;}
+            size_type numBlocks = (_ei - _bi) + 2;
+            if (numBlocks == size_type(_cei - _cbi + 1))
+                return;
+            map_allocator_type pa = map_allocator();
+            T** newCont = map_traits::allocate(pa, numBlocks);
+            std::copy(_bi - 1, _ei + 1, newCont);
+            this->stat_map(numBlocks * sizeof(T*));
+            std::fill(_bi - 1, _ei + 1, static_cast<T*>(0));
+            free_map();
+            _cont = _cbi = newCont;
+            _cei = &_cont[numBlocks - 1];
+            _ei = &_cont[numBlocks - 1];
+            _bi = &_cont[1];
+            assert(valid());}
 
         // ----
         // size
@@ -1077,17 +2771,67 @@ class my_deque {
         size_type size () const {
             return _size;}
 
+        // -----
+        // stats
+        // -----
+
+        /**
+         * returns the counters, all zero unless SP is deque_counting_stats
+         */
+        const deque_stats& stats () const {
+            return this->stat_counters();}
+
+        /**
+         * zeroes the counters and restarts the peaks from the current size and capacity
+         */
+        void reset_stats () {
+            this->stat_reset();
+            this->stat_peaks(_size, BS);}
+
+        // ------------
+        // spare_blocks
+        // ------------
+
+        /**
+         * returns the most empty blocks kept at each end
+         */
+        size_type spare_blocks () const {
+            return _spare;}
+
+        /**
+         * sets the most empty blocks kept at each end and gives back the rest
+         */
+        void spare_blocks (size_type n) {
+            _spare = n;
+            if (_cont)
+                trim_blocks();
+            assert(valid());}
+
         // ----
         // swap
         // ----
 
         /**
          * swaps the values of the deques
+         * exchanges the maps and cursors, no element is touched
+         * allocators that do not propagate on swap must compare equal
          */
-        void swap (my_deque& that) {
-            my_deque x(*this);
-            *this = that;
-            that = x;
+        void swap (my_deque& that) noexcept {
+            deque_swap_allocator(_a, that._a, typename traits::propagate_on_container_swap());
+            std::swap(_size, that._size);
+            std::swap(_b,    that._b);
+            std::swap(_e,    that._e);
+            std::swap(_bi,   that._bi);
+            std::swap(_ei,   that._ei);
+            std::swap(_cbi,  that._cbi);
+            std::swap(_cei,  that._cei);
+            std::swap(_cont, that._cont);
+            std::swap(_spare, that._spare);
+            std::swap(_reserve_front, that._reserve_front);
+            std::swap(_reserve_back,  that._reserve_back);
+            this->stat_swap(that);
+            this->stat_peaks(_size, BS);
+            that.stat_peaks(that._size, BS);
             assert(valid());}};
 
 #endif // Deque_h
@@ -0,0 +1,358 @@
+// -------------------------------
+// projects/deque/DequeAlgorithm.h
+// Copyright (C) 2014
+// Glenn P. Downing
+// -------------------------------
+
+#ifndef DequeAlgorithm_h
+#define DequeAlgorithm_h
+
+// --------
+// includes
+// --------
+
+#include <cassert> // assert
+#include <cstddef> // size_t
+
+#include "Deque.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DEQUE_SIMD_X86 1
+#include <immintrin.h> // _mm256_*
+#endif
+
+// --------------
+// deque_has_avx2
+// --------------
+
+/**
+ * returns true if the running cpu has AVX2, checked once
+ */
+inline bool deque_has_avx2 () {
+#ifdef DEQUE_SIMD_X86
+    static const bool x = __builtin_cpu_supports("avx2");
+#else
+    static const bool x = false;
+#endif
+    return x;}
+
+// --------------------
+// deque_scalar_kernels
+// --------------------
+
+/**
+ * reductions and searches over one contiguous run of n elements
+ * four accumulators keep the loops free of a serial dependency,
+ * so the compiler can vectorize them for the baseline instruction set
+ */
+template <typename T>
+struct deque_scalar_kernels {
+    static T sum (const T* p, std::size_t n, T x) {
+        T a = T(), b = T(), c = T(), d = T();
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            a += p[i];
+            b += p[i + 1];
+            c += p[i + 2];
+            d += p[i + 3];}
+        for (; i != n; ++i)
+            a += p[i];
+        return x + ((a + b) + (c + d));}
+
+    static T min (const T* p, std::size_t n, T x) {
+        for (std::size_t i = 0; i != n; ++i)
+            if (p[i] < x)
+                x = p[i];
+        return x;}
+
+    static T max (const T* p, std::size_t n, T x) {
+        for (std::size_t i = 0; i != n; ++i)
+            if (x < p[i])
+                x = p[i];
+        return x;}
+
+    static std::size_t count (const T* p, std::size_t n, const T& v) {
+        std::size_t c = 0;
+        for (std::size_t i = 0; i != n; ++i)
+            c += (p[i] == v);
+        return c;}
+
+    /**
+     * index of the first element equal to v, n if there is none
+     */
+    static std::size_t find (const T* p, std::size_t n, const T& v) {
+        std::size_t i = 0;
+        while ((i != n) && !(p[i] == v))
+            ++i;
+        return i;}};
+
+// -------------
+// deque_kernels
+// -------------
+
+/**
+ * the kernels used for T, scalar unless specialized below
+ */
+template <typename T>
+struct deque_kernels : deque_scalar_kernels<T> {};
+
+#ifdef DEQUE_SIMD_X86
+
+// ------------------
+// deque_avx2_kernels
+// ------------------
+
+/**
+ * AVX2 versions of the kernels for int and double
+ * only called after deque_has_avx2() says the cpu can run them
+ */
+struct deque_avx2_kernels {
+    __attribute__((target("avx2")))
+    static int sum (const int* p, std::size_t n, int x) {
+        __m256i a = _mm256_setzero_si256();
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+            a = _mm256_add_epi32(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+        __m128i h = _mm_add_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+        h = _mm_add_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(1, 0, 3, 2)));
+        h = _mm_add_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(2, 3, 0, 1)));
+        unsigned s = unsigned(x) + unsigned(_mm_cvtsi128_si32(h));
+        for (; i != n; ++i)
+            s += unsigned(p[i]);
+        return int(s);}
+
+    __attribute__((target("avx2")))
+    static int min (const int* p, std::size_t n, int x) {
+        if (n < 8)
+            return deque_scalar_kernels<int>::min(p, n, x);
+        __m256i a = _mm256_set1_epi32(x);
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+            a = _mm256_min_epi32(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+        __m128i h = _mm_min_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+        h = _mm_min_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(1, 0, 3, 2)));
+        h = _mm_min_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(2, 3, 0, 1)));
+        return deque_scalar_kernels<int>::min(p + i, n - i, _mm_cvtsi128_si32(h));}
+
+    __attribute__((target("avx2")))
+    static int max (const int* p, std::size_t n, int x) {
+        if (n < 8)
+            return deque_scalar_kernels<int>::max(p, n, x);
+        __m256i a = _mm256_set1_epi32(x);
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+            a = _mm256_max_epi32(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+        __m128i h = _mm_max_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+        h = _mm_max_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(1, 0, 3, 2)));
+        h = _mm_max_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(2, 3, 0, 1)));
+        return deque_scalar_kernels<int>::max(p + i, n - i, _mm_cvtsi128_si32(h));}
+
+    __attribute__((target("avx2")))
+    static std::size_t count (const int* p, std::size_t n, const int& v) {
+        __m256i k = _mm256_set1_epi32(v);
+        std::size_t c = 0;
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i e = _mm256_cmpeq_epi32(k, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+            c += __builtin_popcount(unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(e))));}
+        return c + deque_scalar_kernels<int>::count(p + i, n - i, v);}
+
+    __attribute__((target("avx2")))
+    static std::size_t find (const int* p, std::size_t n, const int& v) {
+        __m256i k = _mm256_set1_epi32(v);
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i e = _mm256_cmpeq_epi32(k, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+            int m = _mm256_movemask_ps(_mm256_castsi256_ps(e));
+            if (m)
+                return i + __builtin_ctz(unsigned(m));}
+        return i + deque_scalar_kernels<int>::find(p + i, n - i, v);}
+
+    __attribute__((target("avx2")))
+    static double sum (const double* p, std::size_t n, double x) {
+        __m256d a = _mm256_setzero_pd();
+        __m256d b = _mm256_setzero_pd();
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            a = _mm256_add_pd(a, _mm256_loadu_pd(p + i));
+            b = _mm256_add_pd(b, _mm256_loadu_pd(p + i + 4));}
+        a = _mm256_add_pd(a, b);
+        __m128d h = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+        h = _mm_add_sd(h, _mm_unpackhi_pd(h, h));
+        double s = x + _mm_cvtsd_f64(h);
+        for (; i != n; ++i)
+            s += p[i];
+        return s;}
+
+    __attribute__((target("avx2")))
+    static double min (const double* p, std::size_t n, double x) {
+        if (n < 4)
+            return deque_scalar_kernels<double>::min(p, n, x);
+        __m256d a = _mm256_set1_pd(x);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            a = _mm256_min_pd(_mm256_loadu_pd(p + i), a);
+        __m128d h = _mm_min_pd(_mm256_extractf128_pd(a, 1), _mm256_castpd256_pd128(a));
+        h = _mm_min_sd(_mm_unpackhi_pd(h, h), h);
+        return deque_scalar_kernels<double>::min(p + i, n - i, _mm_cvtsd_f64(h));}
+
+    __attribute__((target("avx2")))
+    static double max (const double* p, std::size_t n, double x) {
+        if (n < 4)
+            return deque_scalar_kernels<double>::max(p, n, x);
+        __m256d a = _mm256_set1_pd(x);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            a = _mm256_max_pd(_mm256_loadu_pd(p + i), a);
+        __m128d h = _mm_max_pd(_mm256_extractf128_pd(a, 1), _mm256_castpd256_pd128(a));
+        h = _mm_max_sd(_mm_unpackhi_pd(h, h), h);
+        return deque_scalar_kernels<double>::max(p + i, n - i, _mm_cvtsd_f64(h));}
+
+    __attribute__((target("avx2")))
+    static std::size_t count (const double* p, std::size_t n, const double& v) {
+        __m256d k = _mm256_set1_pd(v);
+        std::size_t c = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d e = _mm256_cmp_pd(k, _mm256_loadu_pd(p + i), _CMP_EQ_OQ);
+            c += __builtin_popcount(unsigned(_mm256_movemask_pd(e)));}
+        return c + deque_scalar_kernels<double>::count(p + i, n - i, v);}
+
+    __attribute__((target("avx2")))
+    static std::size_t find (const double* p, std::size_t n, const double& v) {
+        __m256d k = _mm256_set1_pd(v);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            int m = _mm256_movemask_pd(_mm256_cmp_pd(k, _mm256_loadu_pd(p + i), _CMP_EQ_OQ));
+            if (m)
+                return i + __builtin_ctz(unsigned(m));}
+        return i + deque_scalar_kernels<double>::find(p + i, n - i, v);}};
+
+// ------------------------
+// deque_dispatched_kernels
+// ------------------------
+
+/**
+ * picks the AVX2 kernel when the cpu has it, the scalar one otherwise
+ */
+template <typename T>
+struct deque_dispatched_kernels {
+    static T sum (const T* p, std::size_t n, T x) {
+        return deque_has_avx2() ? deque_avx2_kernels::sum(p, n, x) : deque_scalar_kernels<T>::sum(p, n, x);}
+
+    static T min (const T* p, std::size_t n, T x) {
+        return deque_has_avx2() ? deque_avx2_kernels::min(p, n, x) : deque_scalar_kernels<T>::min(p, n, x);}
+
+    static T max (const T* p, std::size_t n, T x) {
+        return deque_has_avx2() ? deque_avx2_kernels::max(p, n, x) : deque_scalar_kernels<T>::max(p, n, x);}
+
+    static std::size_t count (const T* p, std::size_t n, const T& v) {
+        return deque_has_avx2() ? deque_avx2_kernels::count(p, n, v) : deque_scalar_kernels<T>::count(p, n, v);}
+
+    static std::size_t find (const T* p, std::size_t n, const T& v) {
+        return deque_has_avx2() ? deque_avx2_kernels::find(p, n, v) : deque_scalar_kernels<T>::find(p, n, v);}};
+
+template <>
+struct deque_kernels<int> : deque_dispatched_kernels<int> {};
+
+template <>
+struct deque_kernels<double> : deque_dispatched_kernels<double> {};
+
+#endif // DEQUE_SIMD_X86
+
+// ----------------
+// deque_accumulate
+// ----------------
+
+/**
+ * returns x plus the sum of the elements, a block at a time
+ * floating point sums are reassociated, so they can differ from a left fold in the last bits
+ */
+template <typename T, typename A, std::size_t BS, typename SP>
+T deque_accumulate (const my_deque<T, A, BS, SP>& d, T x) {
+    d.for_each_segment([&x] (const T* p, std::size_t n) {
+        x = deque_kernels<T>::sum(p, n, x);});
+    return x;}
+
+// ---------
+// deque_sum
+// ---------
+
+/**
+ * returns the sum of the elements
+ */
+template <typename T, typename A, std::size_t BS, typename SP>
+T deque_sum (const my_deque<T, A, BS, SP>& d) {
+    return deque_accumulate(d, T());}
+
+// ---------
+// deque_min
+// ---------
+
+/**
+ * returns the smallest element of a non-empty deque
+ */
+template <typename T, typename A, std::size_t BS, typename SP>
+T deque_min (const my_deque<T, A, BS, SP>& d) {
+    assert(!d.empty());
+    T x = d.front();
+    d.for_each_segment([&x] (const T* p, std::size_t n) {
+        x = deque_kernels<T>::min(p, n, x);});
+    return x;}
+
+// ---------
+// deque_max
+// ---------
+
+/**
+ * returns the largest element of a non-empty deque
+ */
+template <typename T, typename A, std::size_t BS, typename SP>
+T deque_max (const my_deque<T, A, BS, SP>& d) {
+    assert(!d.empty());
+    T x = d.front();
+    d.for_each_segment([&x] (const T* p, std::size_t n) {
+        x = deque_kernels<T>::max(p, n, x);});
+    return x;}
+
+// -----------
+// deque_count
+// -----------
+
+/**
+ * returns how many elements equal v
+ */
+template <typename T, typename A, std::size_t BS, typename SP>
+typename my_deque<T, A, BS, SP>::size_type deque_count (const my_deque<T, A, BS, SP>& d, const T& v) {
+    typename my_deque<T, A, BS, SP>::size_type c = 0;
+    d.for_each_segment([&c, &v] (const T* p, std::size_t n) {
+        c += deque_kernels<T>::count(p, n, v);});
+    return c;}
+
+// ----------
+// deque_find
+// ----------
+
+/**
+ * returns the first element equal to v, end() if there is none
+ */
+template <typename T, typename A, std::size_t BS, typename SP>
+typename my_deque<T, A, BS, SP>::const_iterator deque_find (const my_deque<T, A, BS, SP>& d, const T& v) {
+    typedef typename my_deque<T, A, BS, SP>::const_segment const_segment;
+    typename my_deque<T, A, BS, SP>::size_type i = 0;
+    for (const_segment s : d.segments()) {
+        std::size_t j = deque_kernels<T>::find(s.data, s.size, v);
+        if (j != s.size)
+            return d.begin() + (i + j);
+        i += s.size;}
+    return d.end();}
+
+/**
+ * returns the first element equal to v, end() if there is none
+ */
+template <typename T, typename A, std::size_t BS, typename SP>
+typename my_deque<T, A, BS, SP>::iterator deque_find (my_deque<T, A, BS, SP>& d, const T& v) {
+    const my_deque<T, A, BS, SP>& c = d;
+    return d.begin() + (deque_find(c, v) - c.begin());}
+
+#endif // DequeAlgorithm_h
@@ -0,0 +1,365 @@
+// -------------------------------
+// projects/deque/DequeAllocator.h
+// Copyright (C) 2014
+// Glenn P. Downing
+// -------------------------------
+
+#ifndef DequeAllocator_h
+#define DequeAllocator_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>       // assert
+#include <cstddef>       // size_t
+#include <cstdint>       // uintptr_t
+#include <cstdlib>       // free, posix_memalign
+#include <mutex>         // lock_guard, mutex
+#include <new>           // bad_alloc
+#include <type_traits>   // true_type
+#include <unordered_map> // unordered_map
+#include <vector>        // vector
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h> // madvise, mmap, munmap
+    #if defined(MAP_ANONYMOUS)
+        #define DEQUE_HAVE_MMAP 1
+    #endif
+#endif
+
+// ----------------
+// deque_cache_line
+// ----------------
+
+// bytes in a cache line on the machines we run on
+const std::size_t deque_cache_line = 64;
+
+// ----------------
+// deque_simd_width
+// ----------------
+
+// bytes in the widest vector register the compiler may use
+#if defined(__AVX512F__)
+const std::size_t deque_simd_width = 64;
+#elif defined(__AVX__)
+const std::size_t deque_simd_width = 32;
+#else
+const std::size_t deque_simd_width = 16;
+#endif
+
+// -------------------
+// deque_aligned_alloc
+// -------------------
+
+/**
+ * n bytes aligned to a, a a power of two
+ */
+inline void* deque_aligned_alloc (std::size_t n, std::size_t a) {
+    if (a < sizeof(void*))
+        a = sizeof(void*);
+    void* p = 0;
+    if (posix_memalign(&p, a, n ? n : 1) != 0)
+        throw std::bad_alloc();
+    return p;}
+
+// -----------------------
+// deque_aligned_allocator
+// -----------------------
+
+/**
+ * an allocator whose every allocation starts on an Align byte boundary,
+ * so a my_deque block never shares its first cache line with another block
+ * and SIMD loads from the start of a block are aligned
+ * use Align = deque_simd_width for the vector width instead of the cache line
+ */
+template <typename T, std::size_t Align = deque_cache_line>
+struct deque_aligned_allocator {
+    static_assert((Align & (Align - 1)) == 0, "deque_aligned_allocator: Align must be a power of two");
+
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind {
+        typedef deque_aligned_allocator<U, Align> other;};
+
+    deque_aligned_allocator () noexcept {}
+
+    template <typename U>
+    deque_aligned_allocator (const deque_aligned_allocator<U, Align>&) noexcept {}
+
+    T* allocate (std::size_t n) {
+        return static_cast<T*>(deque_aligned_alloc(n * sizeof(T), (Align > alignof(T)) ? Align : alignof(T)));}
+
+    void deallocate (T* p, std::size_t) noexcept {
+        std::free(p);}};
+
+template <typename T, typename U, std::size_t Align>
+bool operator == (const deque_aligned_allocator<T, Align>&, const deque_aligned_allocator<U, Align>&) {
+    return true;}
+
+template <typename T, typename U, std::size_t Align>
+bool operator != (const deque_aligned_allocator<T, Align>&, const deque_aligned_allocator<U, Align>&) {
+    return false;}
+
+// ----------------------
+// deque_huge_page_region
+// ----------------------
+
+/**
+ * carves cache line aligned pieces out of large mmap regions advised with MADV_HUGEPAGE,
+ * so the blocks of a big deque share a few 2 MiB pages instead of thousands of 4 KiB ones
+ * if mmap is missing or fails, regions come from posix_memalign and use normal pages;
+ * if the kernel refuses the advice, the regions stay mapped with normal pages too
+ * pieces that are given back go on a free list by size, so a deque that recycles blocks
+ * keeps reusing them; the regions themselves are unmapped only by the destructor
+ * thread safe
+ */
+class deque_huge_page_region {
+    public:
+        // bytes in one transparent huge page
+        static const std::size_t huge_page_bytes = std::size_t(2) << 20;
+
+        // every piece starts on a cache line
+        static const std::size_t alignment = deque_cache_line;
+
+    private:
+        // ------
+        // region
+        // ------
+
+        struct region {
+            void*       p;
+            std::size_t bytes;
+            bool        mapped;};
+
+        struct free_node {
+            free_node* next;};
+
+        // ----
+        // data
+        // ----
+
+        mutable std::mutex _m;
+        std::size_t _region_bytes;
+        bool        _advise;
+        // set once madvise accepts MADV_HUGEPAGE, guarded by _m like the rest
+        bool        _huge;
+        char*       _p;
+        std::size_t _left;
+
+        std::vector<region>                         _regions;
+        std::unordered_map<std::size_t, free_node*> _free;
+
+    private:
+        // -----
+        // round
+        // -----
+
+        static std::size_t round (std::size_t n, std::size_t m) {
+            return (n + m - 1) / m * m;}
+
+        // ----------
+        // map_region
+        // ----------
+
+        /**
+         * a new region of n bytes, n a multiple of huge_page_bytes, aligned to huge_page_bytes
+         */
+        char* map_region (std::size_t n) {
+            _regions.reserve(_regions.size() + 1);
+            #ifdef DEQUE_HAVE_MMAP
+            // map a huge page more than needed and trim it, so the region starts on a huge page
+            std::size_t m = n + huge_page_bytes;
+            void* q = mmap(0, m, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (q != MAP_FAILED) {
+                char* b = static_cast<char*>(q);
+                char* p = reinterpret_cast<char*>(round(reinterpret_cast<std::uintptr_t>(b), huge_page_bytes));
+                if (p != b)
+                    munmap(b, p - b);
+                if (p + n != b + m)
+                    munmap(p + n, (b + m) - (p + n));
+                #ifdef MADV_HUGEPAGE
+                if (_advise && (madvise(p, n, MADV_HUGEPAGE) == 0))
+                    _huge = true;
+                #endif
+                region r = {p, n, true};
+                _regions.push_back(r);
+                return p;}
+            #endif
+            region r = {deque_aligned_alloc(n, huge_page_bytes), n, false};
+            _regions.push_back(r);
+            return static_cast<char*>(r.p);}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * a region source that maps region_bytes at a time, rounded up to whole huge pages
+         * advise = false maps normal pages, for comparison
+         */
+        explicit deque_huge_page_region (std::size_t region_bytes = std::size_t(64) << 20, bool advise = true) :
+                _region_bytes (round(region_bytes ? region_bytes : 1, huge_page_bytes)),
+                _advise       (advise),
+                _huge         (false),
+                _p            (0),
+                _left         (0)
+            {}
+
+        deque_huge_page_region (const deque_huge_page_region&) = delete;
+        deque_huge_page_region& operator = (const deque_huge_page_region&) = delete;
+
+        // ----------
+        // destructor
+        // ----------
+
+        /**
+         * unmaps every region, nothing carved from them may be used afterwards
+         */
+        ~deque_huge_page_region () {
+            for (std::size_t i = 0; i != _regions.size(); ++i)
+                #ifdef DEQUE_HAVE_MMAP
+                if (_regions[i].mapped)
+                    munmap(_regions[i].p, _regions[i].bytes);
+                else
+                #endif
+                    std::free(_regions[i].p);}
+
+        // --------
+        // allocate
+        // --------
+
+        /**
+         * n bytes aligned to a cache line
+         * a request larger than a region gets a region of its own
+         * the free list for the size is made here, so that deallocate never has to
+         */
+        void* allocate (std::size_t n) {
+            n = round(n ? n : 1, alignment);
+            std::lock_guard<std::mutex> l(_m);
+            free_node*& f = _free[n];
+            if (f) {
+                free_node* p = f;
+                f = p->next;
+                return p;}
+            if (n > _region_bytes)
+                return map_region(round(n, huge_page_bytes));
+            if (n > _left) {
+                _p    = map_region(_region_bytes);
+                _left = _region_bytes;}
+            void* p = _p;
+            _p    += n;
+            _left -= n;
+            return p;}
+
+        // ----------
+        // deallocate
+        // ----------
+
+        /**
+         * puts the n bytes at p on the free list for their size
+         * allocate made the list when it handed the piece out, so nothing here allocates or throws
+         */
+        void deallocate (void* p, std::size_t n) noexcept {
+            n = round(n ? n : 1, alignment);
+            std::lock_guard<std::mutex> l(_m);
+            std::unordered_map<std::size_t, free_node*>::iterator i = _free.find(n);
+            assert(i != _free.end());
+            if (i == _free.end())
+                return;
+            free_node* x = static_cast<free_node*>(p);
+            x->next   = i->second;
+            i->second = x;}
+
+        // -----------------
+        // huge_page_advised
+        // -----------------
+
+        /**
+         * returns true if madvise accepted MADV_HUGEPAGE for some region
+         * the kernel may still back it with normal pages, with transparent huge pages off
+         * or no huge page free, AnonHugePages in /proc/self/smaps shows what it did
+         */
+        bool huge_page_advised () const {
+            std::lock_guard<std::mutex> l(_m);
+            return _huge;}
+
+        // ------------
+        // mapped_bytes
+        // ------------
+
+        /**
+         * returns the bytes held in regions
+         */
+        std::size_t mapped_bytes () const {
+            std::lock_guard<std::mutex> l(_m);
+            std::size_t s = 0;
+            for (std::size_t i = 0; i != _regions.size(); ++i)
+                s += _regions[i].bytes;
+            return s;}};
+
+// ------------------------------
+// deque_default_huge_page_region
+// ------------------------------
+
+/**
+ * the region a default constructed deque_huge_page_allocator carves from
+ */
+inline deque_huge_page_region& deque_default_huge_page_region () {
+    static deque_huge_page_region x;
+    return x;}
+
+// -------------------------
+// deque_huge_page_allocator
+// -------------------------
+
+/**
+ * an allocator that carves from a deque_huge_page_region
+ * copies share the region and follow the deque on copy, move and swap
+ */
+template <typename T>
+struct deque_huge_page_allocator {
+    static_assert(alignof(T) <= deque_huge_page_region::alignment, "deque_huge_page_allocator: T is over-aligned");
+
+    typedef T value_type;
+
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    template <typename U>
+    struct rebind {
+        typedef deque_huge_page_allocator<U> other;};
+
+    deque_huge_page_region* region;
+
+    deque_huge_page_allocator () noexcept :
+            region (&deque_default_huge_page_region())
+        {}
+
+    explicit deque_huge_page_allocator (deque_huge_page_region& r) noexcept :
+            region (&r)
+        {}
+
+    template <typename U>
+    deque_huge_page_allocator (const deque_huge_page_allocator<U>& that) noexcept :
+            region (that.region)
+        {}
+
+    T* allocate (std::size_t n) {
+        return static_cast<T*>(region->allocate(n * sizeof(T)));}
+
+    void deallocate (T* p, std::size_t n) noexcept {
+        region->deallocate(p, n * sizeof(T));}};
+
+template <typename T, typename U>
+bool operator == (const deque_huge_page_allocator<T>& lhs, const deque_huge_page_allocator<U>& rhs) {
+    return lhs.region == rhs.region;}
+
+template <typename T, typename U>
+bool operator != (const deque_huge_page_allocator<T>& lhs, const deque_huge_page_allocator<U>& rhs) {
+    return !(lhs == rhs);}
+
+#endif // DequeAllocator_h
@@ -0,0 +1,67 @@
+// ---------------------------------------
+// projects/deque/DequeCountingAllocator.h
+// Copyright (C) 2014
+// Glenn P. Downing
+// ---------------------------------------
+
+#ifndef DequeCountingAllocator_h
+#define DequeCountingAllocator_h
+
+// --------
+// includes
+// --------
+
+#include <cstddef> // size_t
+#include <memory>  // allocator
+
+// ------------------------
+// counting_allocator_calls
+// ------------------------
+
+/**
+ * calls to counting_allocator::allocate for every T together, the benchmarks reset it between runs
+ */
+inline long& counting_allocator_calls () {
+    static long n = 0;
+    return n;}
+
+// ------------------
+// counting_allocator
+// ------------------
+
+/**
+ * a std::allocator that counts, for the tests and the benchmarks
+ * live is the number of T allocated and not given back yet, calls the number of calls to allocate,
+ * both kept for each T, so a deque's blocks and its map are counted apart
+ */
+template <typename T>
+struct counting_allocator : std::allocator<T> {
+    template <typename U>
+    struct rebind {
+        typedef counting_allocator<U> other;};
+
+    static long live;
+    static long calls;
+
+    counting_allocator () noexcept {}
+
+    template <typename U>
+    counting_allocator (const counting_allocator<U>&) noexcept {}
+
+    T* allocate (std::size_t n) {
+        live += n;
+        ++calls;
+        ++counting_allocator_calls();
+        return std::allocator<T>::allocate(n);}
+
+    void deallocate (T* p, std::size_t n) {
+        live -= n;
+        std::allocator<T>::deallocate(p, n);}};
+
+template <typename T>
+long counting_allocator<T>::live = 0;
+
+template <typename T>
+long counting_allocator<T>::calls = 0;
+
+#endif // DequeCountingAllocator_h
@@ -0,0 +1,320 @@
+// ----------------------------
+// projects/deque/DequeMemory.h
+// Copyright (C) 2014
+// Glenn P. Downing
+// ----------------------------
+
+#ifndef DequeMemory_h
+#define DequeMemory_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>       // max
+#include <cstddef>         // max_align_t, size_t
+#include <memory>          // align
+#include <memory_resource> // get_default_resource, memory_resource, polymorphic_allocator
+#include <vector>          // vector
+
+#include "Deque.h"
+
+// ---------
+// pmr_deque
+// ---------
+
+/**
+ * a my_deque whose blocks, map and (through uses-allocator construction) elements
+ * all come from one memory_resource
+ */
+template <typename T, std::size_t BS = deque_block_size<T>::value>
+using pmr_deque = my_deque<T, std::pmr::polymorphic_allocator<T>, BS>;
+
+// ---------------------
+// deque_monotonic_arena
+// ---------------------
+
+/**
+ * a memory_resource that hands out memory by bumping a pointer through chunks
+ * taken from upstream, each chunk twice the size of the one before
+ * deallocate does nothing, release (or the destructor) gives every chunk back at once
+ * so a deque that lives in one request can be dropped with the arena
+ * not thread safe
+ */
+class deque_monotonic_arena : public std::pmr::memory_resource {
+    private:
+        // -----
+        // chunk
+        // -----
+
+        // heads every chunk, sized so that what follows it is max aligned
+        struct alignas(std::max_align_t) chunk {
+            chunk*      next;
+            std::size_t size;};
+
+        // ----
+        // data
+        // ----
+
+        std::pmr::memory_resource* _upstream;
+        chunk*                     _chunks;
+        char*                      _p;
+        std::size_t                _left;
+        std::size_t                _initial;
+        std::size_t                _next;
+        std::size_t                _used;
+
+    private:
+        // ----
+        // grow
+        // ----
+
+        /**
+         * starts a chunk with room for at least n bytes
+         */
+        void grow (std::size_t n) {
+            std::size_t s = std::max(_next, sizeof(chunk) + n);
+            chunk* c = static_cast<chunk*>(_upstream->allocate(s, alignof(chunk)));
+            c->next = _chunks;
+            c->size = s;
+            _chunks = c;
+            _p      = reinterpret_cast<char*>(c + 1);
+            _left   = s - sizeof(chunk);
+            _next   = 2 * s;}
+
+        // -----------
+        // do_allocate
+        // -----------
+
+        void* do_allocate (std::size_t n, std::size_t a) override {
+            void* p = _p;
+            if (!_chunks || !std::align(a, n, p, _left)) {
+                grow(n + a);
+                p = _p;
+                std::align(a, n, p, _left);}
+            _p     = static_cast<char*>(p) + n;
+            _left -= n;
+            _used += n;
+            return p;}
+
+        // -------------
+        // do_deallocate
+        // -------------
+
+        void do_deallocate (void*, std::size_t, std::size_t) override {}
+
+        // -----------
+        // do_is_equal
+        // -----------
+
+        bool do_is_equal (const std::pmr::memory_resource& that) const noexcept override {
+            return this == &that;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * an arena whose first chunk holds about initial bytes
+         */
+        explicit deque_monotonic_arena (std::size_t initial = 65536,
+                                        std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) :
+                _upstream (upstream),
+                _chunks   (0),
+                _p        (0),
+                _left     (0),
+                _initial  (std::max<std::size_t>(initial, 2 * sizeof(chunk))),
+                _next     (_initial),
+                _used     (0)
+            {}
+
+        deque_monotonic_arena (const deque_monotonic_arena&) = delete;
+        deque_monotonic_arena& operator = (const deque_monotonic_arena&) = delete;
+
+        // ----------
+        // destructor
+        // ----------
+
+        ~deque_monotonic_arena () {
+            release();}
+
+        // -------
+        // release
+        // -------
+
+        /**
+         * gives every chunk back to upstream
+         * nothing allocated from the arena may be used afterwards
+         */
+        void release () {
+            while (_chunks) {
+                chunk* c = _chunks;
+                _chunks = c->next;
+                _upstream->deallocate(c, c->size, alignof(chunk));}
+            _p    = 0;
+            _left = 0;
+            _next = _initial;
+            _used = 0;}
+
+        // ----
+        // used
+        // ----
+
+        /**
+         * returns the bytes handed out since the last release
+         */
+        std::size_t used () const {
+            return _used;}};
+
+// ----------------
+// deque_block_pool
+// ----------------
+
+/**
+ * a memory_resource that keeps a free list of blocks of exactly BS elements of T,
+ * the size every my_deque<T, A, BS> block has
+ * blocks are carved from upstream chunks of blocks_per_chunk at a time and are never
+ * given back before release, so a deque that grows and shrinks reuses the same blocks
+ * any other request, such as the deque's map, goes straight to upstream
+ * not thread safe
+ */
+template <typename T, std::size_t BS = deque_block_size<T>::value>
+class deque_block_pool : public std::pmr::memory_resource {
+    public:
+        // bytes in one block
+        static const std::size_t block_bytes = sizeof(T) * BS;
+
+    private:
+        // ----
+        // node
+        // ----
+
+        struct node {
+            node* next;};
+
+        static const std::size_t slot_align = (alignof(T) > alignof(node)) ? alignof(T) : alignof(node);
+        static const std::size_t slot_bytes =
+            ((std::max(block_bytes, sizeof(node)) + slot_align - 1) / slot_align) * slot_align;
+
+        // ----
+        // data
+        // ----
+
+        std::pmr::memory_resource* _upstream;
+        std::size_t                _per_chunk;
+        node*                      _free;
+        std::size_t                _free_count;
+        std::vector<void*>         _chunks;
+
+    private:
+        // -----
+        // fresh
+        // -----
+
+        /**
+         * carves one more chunk into the free list
+         */
+        void fresh () {
+            _chunks.reserve(_chunks.size() + 1);
+            char* p = static_cast<char*>(_upstream->allocate(_per_chunk * slot_bytes, slot_align));
+            _chunks.push_back(p);
+            for (std::size_t i = _per_chunk; i != 0; --i) {
+                node* n = reinterpret_cast<node*>(p + (i - 1) * slot_bytes);
+                n->next = _free;
+                _free   = n;}
+            _free_count += _per_chunk;}
+
+        // -------
+        // pooled
+        // -------
+
+        static bool pooled (std::size_t n, std::size_t a) {
+            return (n == block_bytes) && (a <= slot_align);}
+
+        // -----------
+        // do_allocate
+        // -----------
+
+        void* do_allocate (std::size_t n, std::size_t a) override {
+            if (!pooled(n, a))
+                return _upstream->allocate(n, a);
+            if (!_free)
+                fresh();
+            node* p = _free;
+            _free = p->next;
+            --_free_count;
+            return p;}
+
+        // -------------
+        // do_deallocate
+        // -------------
+
+        void do_deallocate (void* p, std::size_t n, std::size_t a) override {
+            if (!pooled(n, a)) {
+                _upstream->deallocate(p, n, a);
+                return;}
+            node* x = static_cast<node*>(p);
+            x->next = _free;
+            _free   = x;
+            ++_free_count;}
+
+        // -----------
+        // do_is_equal
+        // -----------
+
+        bool do_is_equal (const std::pmr::memory_resource& that) const noexcept override {
+            return this == &that;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * a pool that takes blocks_per_chunk blocks from upstream whenever it runs dry
+         */
+        explicit deque_block_pool (std::size_t blocks_per_chunk = 16,
+                                   std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) :
+                _upstream   (upstream),
+                _per_chunk  (std::max<std::size_t>(blocks_per_chunk, 1)),
+                _free       (0),
+                _free_count (0)
+            {}
+
+        deque_block_pool (const deque_block_pool&) = delete;
+        deque_block_pool& operator = (const deque_block_pool&) = delete;
+
+        // ----------
+        // destructor
+        // ----------
+
+        ~deque_block_pool () {
+            release();}
+
+        // -----------
+        // free_blocks
+        // -----------
+
+        /**
+         * returns the number of blocks waiting on the free list
+         */
+        std::size_t free_blocks () const {
+            return _free_count;}
+
+        // -------
+        // release
+        // -------
+
+        /**
+         * gives every chunk back to upstream
+         * no block from the pool may be in use
+         */
+        void release () {
+            for (std::size_t i = 0; i != _chunks.size(); ++i)
+                _upstream->deallocate(_chunks[i], _per_chunk * slot_bytes, slot_align);
+            _chunks.clear();
+            _free       = 0;
+            _free_count = 0;}};
+
+#endif // DequeMemory_h
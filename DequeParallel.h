@@ -0,0 +1,332 @@
+// ------------------------------
+// projects/deque/DequeParallel.h
+// Copyright (C) 2014
+// Glenn P. Downing
+// ------------------------------
+
+#ifndef DequeParallel_h
+#define DequeParallel_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>          // fill, min
+#include <cassert>            // assert
+#include <condition_variable> // condition_variable
+#include <cstddef>            // size_t
+#include <exception>          // exception_ptr, current_exception, rethrow_exception
+#include <functional>         // function
+#include <mutex>              // lock_guard, mutex, unique_lock
+#include <thread>             // thread
+#include <vector>             // vector
+
+#include "Deque.h"
+
+// -----------------
+// deque_thread_pool
+// -----------------
+
+/**
+ * a fixed set of worker threads that run fork/join jobs
+ * the thread that calls run takes part in the job, so a pool of size n starts n - 1 threads
+ * a job must not call run on the pool that is running it
+ */
+class deque_thread_pool {
+    private:
+        // ----
+        // data
+        // ----
+
+        std::vector<std::thread> _threads;
+
+        // serializes run calls
+        std::mutex _run;
+
+        // guards everything below
+        std::mutex              _m;
+        std::condition_variable _work;
+        std::condition_variable _done;
+
+        std::function<void (std::size_t)> _job;
+        std::size_t        _next;
+        std::size_t        _count;
+        std::size_t        _finished;
+        std::exception_ptr _error;
+        bool               _stop;
+
+    private:
+        // -------
+        // perform
+        // -------
+
+        /**
+         * runs task i of the current job and records it as finished
+         * l is held on entry and on exit
+         */
+        void perform (std::unique_lock<std::mutex>& l, std::size_t i) {
+            l.unlock();
+            std::exception_ptr e;
+            try {
+                _job(i);}
+            catch (...) {
+                e = std::current_exception();}
+            l.lock();
+            if (e && !_error)
+                _error = e;
+            if (++_finished == _count)
+                _done.notify_all();}
+
+        // ------
+        // worker
+        // ------
+
+        /**
+         * body of each worker thread
+         */
+        void worker () {
+            std::unique_lock<std::mutex> l(_m);
+            while (true) {
+                _work.wait(l, [this] {return _stop || (_next < _count);});
+                if (_stop)
+                    return;
+                perform(l, _next++);}}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * a pool of n threads, counting the caller of run
+         */
+        explicit deque_thread_pool (std::size_t n = std::thread::hardware_concurrency()) :
+                _next     (0),
+                _count    (0),
+                _finished (0),
+                _stop     (false) {
+            for (std::size_t i = 1; i < n; ++i)
+                _threads.push_back(std::thread(&deque_thread_pool::worker, this));}
+
+        deque_thread_pool (const deque_thread_pool&) = delete;
+        deque_thread_pool& operator = (const deque_thread_pool&) = delete;
+
+        // ----------
+        // destructor
+        // ----------
+
+        /**
+         * stops and joins the workers
+         */
+        ~deque_thread_pool () {
+            {
+            std::lock_guard<std::mutex> l(_m);
+            _stop = true;
+            }
+            _work.notify_all();
+            for (std::size_t i = 0; i != _threads.size(); ++i)
+                _threads[i].join();}
+
+        // ---
+        // run
+        // ---
+
+        /**
+         * calls f(0) .. f(n - 1) across the pool and returns once they are all done
+         * rethrows the first exception a task threw
+         */
+        template <typename F>
+        void run (std::size_t n, F f) {
+            if (n == 0)
+                return;
+            std::lock_guard<std::mutex>  r(_run);
+            std::unique_lock<std::mutex> l(_m);
+            _job      = f;
+            _next     = 0;
+            _count    = n;
+            _finished = 0;
+            _error    = std::exception_ptr();
+            _work.notify_all();
+            while (_next < _count)
+                perform(l, _next++);
+            _done.wait(l, [this] {return _finished == _count;});
+            _job   = std::function<void (std::size_t)>();
+            _count = _next = 0;
+            if (_error)
+                std::rethrow_exception(_error);}
+
+        // ----
+        // size
+        // ----
+
+        /**
+         * returns the number of threads that run jobs, counting the caller
+         */
+        std::size_t size () const {
+            return _threads.size() + 1;}};
+
+// ------------------
+// deque_default_pool
+// ------------------
+
+/**
+ * the pool used when none is given, one thread per hardware thread
+ */
+inline deque_thread_pool& deque_default_pool () {
+    static deque_thread_pool x;
+    return x;}
+
+// ---------------
+// deque_partition
+// ---------------
+
+/**
+ * splits the segments of a deque into about four runs of whole blocks per pool thread
+ * and calls f(p, n, i) from the pool on every segment, i being the index of *p
+ */
+template <typename D, typename F>
+void deque_partition (D& d, deque_thread_pool& pool, F f) {
+    typedef decltype(*d.segments().begin()) segment;
+    std::vector<segment>     s;
+    std::vector<std::size_t> o;
+    std::size_t i = 0;
+    for (segment x : d.segments()) {
+        s.push_back(x);
+        o.push_back(i);
+        i += x.size;}
+    std::size_t tasks = std::min(s.size(), 4 * pool.size());
+    if (tasks == 0)
+        return;
+    std::size_t k = (s.size() + tasks - 1) / tasks;
+    pool.run((s.size() + k - 1) / k, [&s, &o, k, &f] (std::size_t t) {
+        std::size_t e = std::min(s.size(), (t + 1) * k);
+        for (std::size_t j = t * k; j != e; ++j)
+            f(s[j].data, s[j].size, o[j]);});}
+
+// -----------------------
+// deque_parallel_for_each
+// -----------------------
+
+/**
+ * calls f on every element, each pool thread taking whole blocks
+ */
+template <typename T, typename A, std::size_t BS, typename SP, typename F>
+void deque_parallel_for_each (my_deque<T, A, BS, SP>& d, F f, deque_thread_pool& pool = deque_default_pool()) {
+    deque_partition(d, pool, [&f] (T* p, std::size_t n, std::size_t) {
+        for (std::size_t i = 0; i != n; ++i)
+            f(p[i]);});}
+
+/**
+ * calls f on every const element, each pool thread taking whole blocks
+ */
+template <typename T, typename A, std::size_t BS, typename SP, typename F>
+void deque_parallel_for_each (const my_deque<T, A, BS, SP>& d, F f, deque_thread_pool& pool = deque_default_pool()) {
+    deque_partition(d, pool, [&f] (const T* p, std::size_t n, std::size_t) {
+        for (std::size_t i = 0; i != n; ++i)
+            f(p[i]);});}
+
+// ------------------------
+// deque_parallel_transform
+// ------------------------
+
+/**
+ * replaces every element x with f(x)
+ */
+template <typename T, typename A, std::size_t BS, typename SP, typename F>
+void deque_parallel_transform (my_deque<T, A, BS, SP>& d, F f, deque_thread_pool& pool = deque_default_pool()) {
+    deque_partition(d, pool, [&f] (T* p, std::size_t n, std::size_t) {
+        for (std::size_t i = 0; i != n; ++i)
+            p[i] = f(p[i]);});}
+
+/**
+ * stores f(x) for every element x of in at the same position of out
+ * out must be at least as long as in
+ * the work follows the blocks of in, so threads only meet where a block of out straddles two of them
+ */
+template <typename T, typename A, std::size_t BS, typename SP, typename U, typename B, std::size_t CS, typename SQ,
+          typename F>
+void deque_parallel_transform (const my_deque<T, A, BS, SP>& in, my_deque<U, B, CS, SQ>& out, F f,
+                               deque_thread_pool& pool = deque_default_pool()) {
+    assert(out.size() >= in.size());
+    typedef typename my_deque<U, B, CS, SQ>::iterator iterator;
+    iterator o = out.begin();
+    deque_partition(in, pool, [&f, o] (const T* p, std::size_t n, std::size_t j) {
+        // every task steps its own copy of the iterator
+        iterator x = o + j;
+        for (std::size_t i = 0; i != n; ++i, ++x)
+            *x = f(p[i]);});}
+
+// ---------------------
+// deque_parallel_reduce
+// ---------------------
+
+/**
+ * folds each run of blocks on its own, starting from seed(e) for its first element e
+ * and going on with fold(y, e), then combines x with the partial results in order
+ */
+template <typename T, typename A, std::size_t BS, typename SP, typename R, typename Seed, typename Fold, typename Combine>
+R deque_parallel_fold (const my_deque<T, A, BS, SP>& d, R x, Seed seed, Fold fold, Combine combine,
+                       deque_thread_pool& pool) {
+    typedef typename my_deque<T, A, BS, SP>::const_segment segment;
+    std::vector<segment> s(d.segments().begin(), d.segments().end());
+    std::size_t tasks = std::min(s.size(), 4 * pool.size());
+    if (tasks == 0)
+        return x;
+    std::size_t k = (s.size() + tasks - 1) / tasks;
+    std::size_t m = (s.size() + k - 1) / k;
+    std::vector<R> partial(m);
+    pool.run(m, [&s, &partial, k, &seed, &fold] (std::size_t t) {
+        std::size_t e = std::min(s.size(), (t + 1) * k);
+        R y = seed(s[t * k].data[0]);
+        for (std::size_t i = 1; i != s[t * k].size; ++i)
+            y = fold(y, s[t * k].data[i]);
+        for (std::size_t j = t * k + 1; j != e; ++j)
+            for (std::size_t i = 0; i != s[j].size; ++i)
+                y = fold(y, s[j].data[i]);
+        partial[t] = y;});
+    for (std::size_t t = 0; t != m; ++t)
+        x = combine(x, partial[t]);
+    return x;}
+
+/**
+ * returns x combine fold(identity, e0...) combine ... for the runs of elements
+ * fold(R, const T&) -> R adds an element to a partial result, each run starting from identity
+ * combine(R, R) -> R joins partial results and must be associative, with identity as its identity
+ */
+template <typename T, typename A, std::size_t BS, typename SP, typename R, typename Fold, typename Combine>
+R deque_parallel_reduce (const my_deque<T, A, BS, SP>& d, R x, R identity, Fold fold, Combine combine,
+                         deque_thread_pool& pool = deque_default_pool()) {
+    return deque_parallel_fold(d, x,
+        [&identity, &fold] (const T& e) -> R {return fold(identity, e);}, fold, combine, pool);}
+
+/**
+ * returns x op e0 op e1 op ... op en-1, as std::reduce does
+ * op(R, R) -> R must be associative, every element is converted to R before op sees it
+ */
+template <typename T, typename A, std::size_t BS, typename SP, typename R, typename Op>
+R deque_parallel_reduce (const my_deque<T, A, BS, SP>& d, R x, Op op, deque_thread_pool& pool = deque_default_pool()) {
+    return deque_parallel_fold(d, x,
+        [] (const T& e) -> R {return R(e);},
+        [&op] (const R& a, const T& b) -> R {return op(a, R(b));},
+        op, pool);}
+
+/**
+ * returns x plus the sum of the elements, summed as R
+ */
+template <typename T, typename A, std::size_t BS, typename SP, typename R>
+R deque_parallel_reduce (const my_deque<T, A, BS, SP>& d, R x, deque_thread_pool& pool = deque_default_pool()) {
+    return deque_parallel_reduce(d, x, [] (const R& a, const R& b) -> R {return a + b;}, pool);}
+
+// -------------------
+// deque_parallel_fill
+// -------------------
+
+/**
+ * assigns v to every element, each pool thread taking whole blocks
+ */
+template <typename T, typename A, std::size_t BS, typename SP>
+void deque_parallel_fill (my_deque<T, A, BS, SP>& d, const T& v, deque_thread_pool& pool = deque_default_pool()) {
+    deque_partition(d, pool, [&v] (T* p, std::size_t n, std::size_t) {
+        std::fill(p, p + n, v);});}
+
+#endif // DequeParallel_h
@@ -0,0 +1,481 @@
+// --------------------------
+// projects/deque/DequeRing.h
+// Copyright (C) 2014
+// Glenn P. Downing
+// --------------------------
+
+#ifndef DequeRing_h
+#define DequeRing_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>   // equal, fill, lexicographical_compare
+#include <cassert>     // assert
+#include <cstddef>     // size_t
+#include <memory>      // allocator, allocator_traits
+#include <stdexcept>   // out_of_range
+#include <utility>     // forward, move, swap
+
+#include "Deque.h"
+
+// -----------------
+// deque_ring_policy
+// -----------------
+
+/**
+ * what a full ring_deque does with one more element
+ * deque_ring_fail leaves the deque as it is
+ * deque_ring_overwrite drops the element at the other end to make room
+ */
+enum deque_ring_policy {
+    deque_ring_fail,
+    deque_ring_overwrite};
+
+// ----------
+// ring_deque
+// ----------
+
+/**
+ * a deque of at most capacity elements whose blocks are all allocated by the constructor
+ * the blocks form a ring, so pushing and popping never allocate, free or move the map,
+ * and every push and pop costs the same however long the deque has been running
+ * a push that finds the deque full returns false and follows the policy P
+ * iterators hold an index, like small_deque's
+ */
+template <typename T, deque_ring_policy P = deque_ring_fail, typename A = std::allocator<T>,
+          std::size_t BS = deque_block_size<T>::value>
+class ring_deque {
+    static_assert(BS > 0, "ring_deque: block size must be positive");
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef A                                                  allocator_type;
+        typedef typename allocator_type::value_type                value_type;
+
+        typedef typename std::allocator_traits<A>::size_type       size_type;
+        typedef typename std::allocator_traits<A>::difference_type difference_type;
+
+        typedef typename std::allocator_traits<A>::pointer         pointer;
+        typedef typename std::allocator_traits<A>::const_pointer   const_pointer;
+
+        typedef value_type&                                        reference;
+        typedef const value_type&                                  const_reference;
+
+        typedef deque_index_iterator<ring_deque, T>             iterator;
+        typedef deque_index_iterator<const ring_deque, const T> const_iterator;
+
+        // what a full deque does with one more element
+        static const deque_ring_policy policy = P;
+
+        // number of elements in each block
+        static const size_type block_size = BS;
+
+    public:
+        // -----------
+        // operator ==
+        // -----------
+
+        friend bool operator == (const ring_deque& lhs, const ring_deque& rhs) {
+            return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(), rhs.begin());}
+
+        // ----------
+        // operator <
+        // ----------
+
+        friend bool operator < (const ring_deque& lhs, const ring_deque& rhs) {
+            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());}
+
+        // ----
+        // swap
+        // ----
+
+        friend void swap (ring_deque& lhs, ring_deque& rhs) noexcept {
+            lhs.swap(rhs);}
+
+    private:
+        // --------
+        // typedefs
+        // --------
+
+        typedef typename std::allocator_traits<A>::template rebind_alloc<T*> map_allocator_type;
+
+        typedef std::allocator_traits<A>                  traits;
+        typedef std::allocator_traits<map_allocator_type> map_traits;
+
+        // ----
+        // data
+        // ----
+
+        allocator_type _a;
+
+        // the blocks, enough of them for _cap elements
+        T**       _map;
+        size_type _blocks;
+        size_type _cap;
+
+        // the elements are the _n slots of the ring starting at slot _h
+        size_type _h;
+        size_type _n;
+
+    private:
+        // -----------
+        // block_index
+        // -----------
+
+        static size_type block_index (size_type o) {
+            return ((BS & (BS - 1)) == 0) ? (o >> deque_log2(BS)) : (o / BS);}
+
+        // ------------
+        // block_offset
+        // ------------
+
+        static size_type block_offset (size_type o) {
+            return ((BS & (BS - 1)) == 0) ? (o & (BS - 1)) : (o % BS);}
+
+        // ----
+        // slot
+        // ----
+
+        /**
+         * the slot of the ring i slots past _h, i < 2 * _cap
+         */
+        pointer slot (size_type i) const {
+            size_type o = _h + i;
+            if (o >= _cap)
+                o -= _cap;
+            return _map[block_index(o)] + block_offset(o);}
+
+        // ----------
+        // allocate
+        // ----------
+
+        /**
+         * allocates the map and every block for c elements
+         */
+        void allocate (size_type c) {
+            _cap    = c;
+            _blocks = (c == 0) ? 0 : block_index(c - 1) + 1;
+            _map    = 0;
+            if (_blocks == 0)
+                return;
+            map_allocator_type pa(_a);
+            _map = map_traits::allocate(pa, _blocks);
+            std::fill(_map, _map + _blocks, static_cast<T*>(0));
+            try {
+                for (size_type i = 0; i != _blocks; ++i)
+                    _map[i] = traits::allocate(_a, BS);}
+            catch (...) {
+                deallocate();
+                throw;}}
+
+        // ----------
+        // deallocate
+        // ----------
+
+        /**
+         * gives back the blocks and the map, the elements must already be destroyed
+         */
+        void deallocate () {
+            if (!_map)
+                return;
+            for (size_type i = 0; i != _blocks; ++i)
+                if (_map[i])
+                    traits::deallocate(_a, _map[i], BS);
+            map_allocator_type pa(_a);
+            map_traits::deallocate(pa, _map, _blocks);
+            _map = 0;}
+
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return (_n <= _cap) && ((_cap == 0) || (_h < _cap)) && (!_map == !_blocks);}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * an empty deque that holds up to capacity elements
+         * this is the only call that allocates
+         */
+        explicit ring_deque (size_type capacity, const allocator_type& a = allocator_type()) :
+                _a (a),
+                _h (0),
+                _n (0) {
+            allocate(capacity);
+            assert(valid());}
+
+        /**
+         * a deque with the capacity and the elements of that
+         */
+        ring_deque (const ring_deque& that) :
+                _a (traits::select_on_container_copy_construction(that._a)),
+                _h (0),
+                _n (0) {
+            allocate(that._cap);
+            try {
+                for (; _n != that._n; ++_n)
+                    traits::construct(_a, slot(_n), that[_n]);}
+            catch (...) {
+                clear();
+                deallocate();
+                throw;}
+            assert(valid());}
+
+        /**
+         * takes over that's blocks, leaving that with a capacity of 0
+         */
+        ring_deque (ring_deque&& that) noexcept :
+                _a      (std::move(that._a)),
+                _map    (that._map),
+                _blocks (that._blocks),
+                _cap    (that._cap),
+                _h      (that._h),
+                _n      (that._n) {
+            that._map    = 0;
+            that._blocks = 0;
+            that._cap    = 0;
+            that._h      = 0;
+            that._n      = 0;
+            assert(valid());}
+
+        // ----------
+        // destructor
+        // ----------
+
+        ~ring_deque () {
+            clear();
+            deallocate();}
+
+        // ----------
+        // operator =
+        // ----------
+
+        /**
+         * takes the capacity and the elements of rhs
+         */
+        ring_deque& operator = (const ring_deque& rhs) {
+            ring_deque x(rhs);
+            swap(x);
+            return *this;}
+
+        /**
+         * takes over rhs's blocks, leaving rhs with a capacity of 0
+         */
+        ring_deque& operator = (ring_deque&& rhs) noexcept {
+            ring_deque x(std::move(rhs));
+            swap(x);
+            return *this;}
+
+        // -----------
+        // operator []
+        // -----------
+
+        reference operator [] (size_type i) {
+            return *slot(i);}
+
+        const_reference operator [] (size_type i) const {
+            return *slot(i);}
+
+        // --
+        // at
+        // --
+
+        reference at (size_type i) {
+            if (i >= size())
+                throw std::out_of_range("ring_deque");
+            return (*this)[i];}
+
+        const_reference at (size_type i) const {
+            return const_cast<ring_deque*>(this)->at(i);}
+
+        // ----
+        // back
+        // ----
+
+        reference back () {
+            assert(!empty());
+            return *slot(_n - 1);}
+
+        const_reference back () const {
+            return const_cast<ring_deque*>(this)->back();}
+
+        // -----
+        // begin
+        // -----
+
+        iterator begin () {
+            return iterator(this, 0);}
+
+        const_iterator begin () const {
+            return const_iterator(this, 0);}
+
+        // --------
+        // capacity
+        // --------
+
+        /**
+         * returns the most elements the deque holds
+         */
+        size_type capacity () const {
+            return _cap;}
+
+        // -----
+        // clear
+        // -----
+
+        /**
+         * destroys every element, the blocks stay
+         */
+        void clear () {
+            destroy(_a, begin(), end());
+            _h = 0;
+            _n = 0;}
+
+        // -------
+        // emplace
+        // -------
+
+        /**
+         * constructs an element from args behind the last element
+         * returns false if the deque was full, in which case deque_ring_overwrite drops the first element
+         */
+        template <typename... Args>
+        bool emplace_back (Args&&... args) {
+            if (_n != _cap) {
+                traits::construct(_a, slot(_n), std::forward<Args>(args)...);
+                ++_n;
+                return true;}
+            if ((P == deque_ring_overwrite) && (_cap != 0)) {
+                // the new last element takes the first one's slot, args may refer to it
+                value_type x(std::forward<Args>(args)...);
+                *slot(0) = std::move(x);
+                _h = (_h + 1 == _cap) ? 0 : _h + 1;}
+            return false;}
+
+        /**
+         * constructs an element from args ahead of the first element
+         * returns false if the deque was full, in which case deque_ring_overwrite drops the last element
+         */
+        template <typename... Args>
+        bool emplace_front (Args&&... args) {
+            if (_n != _cap) {
+                traits::construct(_a, slot(_cap - 1), std::forward<Args>(args)...);
+                _h = (_h == 0) ? _cap - 1 : _h - 1;
+                ++_n;
+                return true;}
+            if ((P == deque_ring_overwrite) && (_cap != 0)) {
+                // the new first element takes the last one's slot, args may refer to it
+                value_type x(std::forward<Args>(args)...);
+                *slot(_cap - 1) = std::move(x);
+                _h = (_h == 0) ? _cap - 1 : _h - 1;}
+            return false;}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return _n == 0;}
+
+        // ---
+        // end
+        // ---
+
+        iterator end () {
+            return iterator(this, _n);}
+
+        const_iterator end () const {
+            return const_iterator(this, _n);}
+
+        // -----
+        // front
+        // -----
+
+        reference front () {
+            assert(!empty());
+            return *slot(0);}
+
+        const_reference front () const {
+            return const_cast<ring_deque*>(this)->front();}
+
+        // ----
+        // full
+        // ----
+
+        /**
+         * returns true if the next push will fail or overwrite
+         */
+        bool full () const {
+            return _n == _cap;}
+
+        // -------------
+        // get_allocator
+        // -------------
+
+        allocator_type get_allocator () const {
+            return _a;}
+
+        // ---
+        // pop
+        // ---
+
+        void pop_back () {
+            assert(!empty());
+            traits::destroy(_a, slot(_n - 1));
+            --_n;}
+
+        void pop_front () {
+            assert(!empty());
+            traits::destroy(_a, slot(0));
+            _h = (_h + 1 == _cap) ? 0 : _h + 1;
+            --_n;}
+
+        // ----
+        // push
+        // ----
+
+        bool push_back (const_reference v) {
+            return emplace_back(v);}
+
+        bool push_back (value_type&& v) {
+            return emplace_back(std::move(v));}
+
+        bool push_front (const_reference v) {
+            return emplace_front(v);}
+
+        bool push_front (value_type&& v) {
+            return emplace_front(std::move(v));}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return _n;}
+
+        // ----
+        // swap
+        // ----
+
+        /**
+         * swaps the blocks of the deques, no element is touched
+         * allocators that do not propagate on swap must compare equal
+         */
+        void swap (ring_deque& that) noexcept {
+            deque_swap_allocator(_a, that._a, typename traits::propagate_on_container_swap());
+            std::swap(_map,    that._map);
+            std::swap(_blocks, that._blocks);
+            std::swap(_cap,    that._cap);
+            std::swap(_h,      that._h);
+            std::swap(_n,      that._n);}};
+
+#endif // DequeRing_h
@@ -0,0 +1,150 @@
+// -------------------------------
+// projects/deque/DequeSerialize.h
+// Copyright (C) 2014
+// Glenn P. Downing
+// -------------------------------
+
+#ifndef DequeSerialize_h
+#define DequeSerialize_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>    // min
+#include <cerrno>       // EINTR, errno
+#include <climits>      // IOV_MAX
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <sstream>      // ostringstream
+#include <stdexcept>    // runtime_error
+#include <string>       // string
+#include <system_error> // generic_category, system_error
+#include <type_traits>  // is_trivially_copyable
+#include <vector>       // vector
+
+#include <sys/uio.h>    // iovec, writev
+
+#include "Deque.h"
+
+// -----------
+// deque_write
+// -----------
+
+/**
+ * writes d to the file descriptor fd in the format of my_deque::serialize,
+ * the header and every block going out through writev, IOV_MAX blocks at a time
+ * throws std::system_error if a write fails
+ */
+template <typename T, typename A, std::size_t BS, typename SP>
+void deque_write (int fd, const my_deque<T, A, BS, SP>& d) {
+    static_assert(std::is_trivially_copyable<T>::value, "deque_write: T must be trivially copyable");
+    #ifdef IOV_MAX
+    const std::size_t most = IOV_MAX;
+    #else
+    const std::size_t most = 1024;
+    #endif
+    std::ostringstream out;
+    deque_binary_header h;
+    h.element_size = sizeof(T);
+    h.count        = d.size();
+    h.write(out);
+    const std::string header = out.str();
+
+    std::vector<iovec> v;
+    iovec x;
+    x.iov_base = const_cast<char*>(header.data());
+    x.iov_len  = header.size();
+    v.push_back(x);
+    for (typename my_deque<T, A, BS, SP>::const_segment s : d.segments()) {
+        x.iov_base = const_cast<T*>(s.data);
+        x.iov_len  = s.size * sizeof(T);
+        v.push_back(x);}
+
+    std::size_t i = 0;
+    while (i != v.size()) {
+        ssize_t n = writev(fd, &v[i], int(std::min(most, v.size() - i)));
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "deque_write");}
+        // skip what went out, a short write may stop in the middle of a block
+        std::size_t k = std::size_t(n);
+        while ((i != v.size()) && (k >= v[i].iov_len))
+            k -= v[i++].iov_len;
+        if (k != 0) {
+            v[i].iov_base = static_cast<char*>(v[i].iov_base) + k;
+            v[i].iov_len -= k;}}}
+
+// -----------------------
+// deque_checkpoint_reader
+// -----------------------
+
+/**
+ * reads a checkpoint written by my_deque::serialize or deque_write a piece at a time,
+ * appending to a deque that stays live in between
+ * the header is read and checked when the reader is made
+ */
+template <typename T>
+class deque_checkpoint_reader {
+    static_assert(std::is_trivially_copyable<T>::value, "deque_checkpoint_reader: T must be trivially copyable");
+
+    private:
+        // ----
+        // data
+        // ----
+
+        std::istream& _in;
+        std::uint64_t _left;
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * throws std::runtime_error if in does not start with a header for T
+         */
+        explicit deque_checkpoint_reader (std::istream& in) :
+                _in   (in),
+                _left (deque_binary_header::read(in, sizeof(T)).count)
+            {}
+
+        // ----
+        // done
+        // ----
+
+        /**
+         * returns true once every element has been read
+         */
+        bool done () const {
+            return _left == 0;}
+
+        // ---------
+        // read_into
+        // ---------
+
+        /**
+         * appends up to n more elements to d, straight into its blocks, and returns how many
+         * throws std::runtime_error if the stream ends early, keeping what was appended
+         */
+        template <typename A, std::size_t BS, typename SP>
+        std::size_t read_into (my_deque<T, A, BS, SP>& d, std::size_t n = BS) {
+            std::size_t k = std::size_t(std::min<std::uint64_t>(n, _left));
+            std::size_t r = d.append_from(_in, k);
+            _left -= r;
+            if (r != k)
+                throw std::runtime_error("deque_checkpoint_reader: truncated stream");
+            return r;}
+
+        // ---------
+        // remaining
+        // ---------
+
+        /**
+         * returns the number of elements not read yet
+         */
+        std::uint64_t remaining () const {
+            return _left;}};
+
+#endif // DequeSerialize_h
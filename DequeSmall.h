@@ -0,0 +1,467 @@
+// ---------------------------
+// projects/deque/DequeSmall.h
+// Copyright (C) 2014
+// Glenn P. Downing
+// ---------------------------
+
+#ifndef DequeSmall_h
+#define DequeSmall_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>   // equal, lexicographical_compare
+#include <cstddef>     // size_t
+#include <memory>      // allocator, allocator_traits
+#include <stdexcept>   // out_of_range
+#include <type_traits> // aligned_storage, is_nothrow_move_constructible
+#include <utility>     // forward, move, move_if_noexcept
+
+#include "Deque.h"
+
+// -----------
+// small_deque
+// -----------
+
+/**
+ * a deque that keeps up to N elements in a ring inside the object
+ * and moves them into a my_deque<T, A, BS> the first time it overflows
+ * a small_deque that never holds more than N elements never allocates
+ * it stays in the my_deque until shrink_to_fit, so a deque that is cleared and refilled reuses its blocks
+ */
+template <typename T, std::size_t N = 8, typename A = std::allocator<T>, std::size_t BS = deque_block_size<T>::value>
+class small_deque {
+    static_assert(N > 0, "small_deque: the inline buffer must hold at least one element");
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef my_deque<T, A, BS>                    deque_type;
+        typedef typename deque_type::allocator_type   allocator_type;
+        typedef typename deque_type::value_type       value_type;
+        typedef typename deque_type::size_type        size_type;
+        typedef typename deque_type::difference_type  difference_type;
+        typedef typename deque_type::pointer          pointer;
+        typedef typename deque_type::const_pointer    const_pointer;
+        typedef typename deque_type::reference        reference;
+        typedef typename deque_type::const_reference  const_reference;
+
+        // elements held inside the object
+        static const size_type inline_capacity = N;
+
+    public:
+        // -----------
+        // operator ==
+        // -----------
+
+        friend bool operator == (const small_deque& lhs, const small_deque& rhs) {
+            return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(), rhs.begin());}
+
+        // ----------
+        // operator <
+        // ----------
+
+        friend bool operator < (const small_deque& lhs, const small_deque& rhs) {
+            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());}
+
+        // ----
+        // swap
+        // ----
+
+        friend void swap (small_deque& lhs, small_deque& rhs) {
+            lhs.swap(rhs);}
+
+    public:
+        // --------
+        // iterator
+        // --------
+
+        // iterators hold an index, so they survive pushes and the spill
+        typedef deque_index_iterator<small_deque, T>             iterator;
+        typedef deque_index_iterator<const small_deque, const T> const_iterator;
+
+    private:
+        // --------
+        // typedefs
+        // --------
+
+        typedef std::allocator_traits<A>                                      traits;
+        typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type slot_type;
+
+        // ----
+        // data
+        // ----
+
+        // holds the elements once they outgrow the buffer
+        deque_type _d;
+
+        // the inline ring, _n elements starting at slot _h
+        slot_type _buf[N];
+        size_type _h;
+        size_type _n;
+
+        // true while the elements live in _d
+        bool _spilled;
+
+    private:
+        // ----
+        // slot
+        // ----
+
+        /**
+         * the inline element at index i
+         */
+        pointer slot (size_type i) {
+            return reinterpret_cast<pointer>(&_buf[(_h + i) % N]);}
+
+        const_pointer slot (size_type i) const {
+            return reinterpret_cast<const_pointer>(&_buf[(_h + i) % N]);}
+
+        // -----
+        // spill
+        // -----
+
+        /**
+         * moves the inline elements into _d, which from now on holds every element
+         * the inline elements are left as they were if that throws
+         */
+        void spill () {
+            _d.reserve_back(N + 1);
+            try {
+                for (size_type i = 0; i != _n; ++i)
+                    _d.emplace_back(std::move_if_noexcept(*slot(i)));}
+            catch (...) {
+                _d.clear();
+                throw;}
+            destroy_inline();
+            _spilled = true;}
+
+        // --------------
+        // destroy_inline
+        // --------------
+
+        void destroy_inline () {
+            allocator_type a = _d.get_allocator();
+            for (size_type i = 0; i != _n; ++i)
+                traits::destroy(a, slot(i));
+            _h = 0;
+            _n = 0;}
+
+        // -------------
+        // steal_inline
+        // -------------
+
+        /**
+         * moves that's inline elements into this deque's empty buffer
+         */
+        void steal_inline (small_deque& that) noexcept(std::is_nothrow_move_constructible<T>::value) {
+            allocator_type a = _d.get_allocator();
+            for (; _n != that._n; ++_n)
+                traits::construct(a, slot(_n), std::move(*that.slot(_n)));
+            that.destroy_inline();}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * an empty deque, allocates nothing
+         */
+        small_deque () noexcept(noexcept(allocator_type())) :
+                _d       (),
+                _h       (0),
+                _n       (0),
+                _spilled (false)
+            {}
+
+        /**
+         * an empty deque whose my_deque will allocate from a, allocates nothing yet
+         */
+        explicit small_deque (const allocator_type& a) noexcept :
+                _d       (a),
+                _h       (0),
+                _n       (0),
+                _spilled (false)
+            {}
+
+        /**
+         * copies that's elements, they stay inline if there are at most N of them
+         */
+        small_deque (const small_deque& that) :
+                small_deque (traits::select_on_container_copy_construction(that.get_allocator())) {
+            for (size_type i = 0; i != that.size(); ++i)
+                push_back(that[i]);}
+
+        /**
+         * takes over that's my_deque or moves its inline elements, leaving that empty
+         */
+        small_deque (small_deque&& that) noexcept(std::is_nothrow_move_constructible<T>::value) :
+                _d       (std::move(that._d)),
+                _h       (0),
+                _n       (0),
+                _spilled (that._spilled) {
+            that._spilled = false;
+            steal_inline(that);}
+
+        // ----------
+        // destructor
+        // ----------
+
+        ~small_deque () {
+            destroy_inline();}
+
+        // ----------
+        // operator =
+        // ----------
+
+        /**
+         * replaces the elements with copies of rhs's, the allocator stays
+         */
+        small_deque& operator = (const small_deque& rhs) {
+            if (this == &rhs)
+                return *this;
+            clear();
+            for (size_type i = 0; i != rhs.size(); ++i)
+                push_back(rhs[i]);
+            return *this;}
+
+        /**
+         * takes over rhs's elements, leaving rhs empty
+         */
+        small_deque& operator = (small_deque&& rhs) {
+            if (this == &rhs)
+                return *this;
+            destroy_inline();
+            if (rhs._spilled) {
+                _d            = std::move(rhs._d);
+                _spilled      = true;
+                rhs._spilled  = false;}
+            else if (_spilled) {
+                _d.clear();
+                for (size_type i = 0; i != rhs._n; ++i)
+                    _d.emplace_back(std::move(*rhs.slot(i)));
+                rhs.destroy_inline();}
+            else
+                steal_inline(rhs);
+            return *this;}
+
+        // -----------
+        // operator []
+        // -----------
+
+        reference operator [] (size_type i) {
+            return _spilled ? _d[i] : *slot(i);}
+
+        const_reference operator [] (size_type i) const {
+            return _spilled ? _d[i] : *slot(i);}
+
+        // --
+        // at
+        // --
+
+        reference at (size_type i) {
+            if (i >= size())
+                throw std::out_of_range("small_deque");
+            return (*this)[i];}
+
+        const_reference at (size_type i) const {
+            return const_cast<small_deque*>(this)->at(i);}
+
+        // ----
+        // back
+        // ----
+
+        reference back () {
+            return _spilled ? _d.back() : *slot(_n - 1);}
+
+        const_reference back () const {
+            return const_cast<small_deque*>(this)->back();}
+
+        // -----
+        // begin
+        // -----
+
+        iterator begin () {
+            return iterator(this, 0);}
+
+        const_iterator begin () const {
+            return const_iterator(this, 0);}
+
+        // -----
+        // clear
+        // -----
+
+        /**
+         * removes every element, a spilled deque keeps its blocks for the next elements
+         */
+        void clear () {
+            if (_spilled)
+                _d.clear();
+            else
+                destroy_inline();}
+
+        // -------
+        // emplace
+        // -------
+
+        /**
+         * constructs an element from args behind the last element
+         */
+        template <typename... Args>
+        void emplace_back (Args&&... args) {
+            if (_spilled) {
+                _d.emplace_back(std::forward<Args>(args)...);
+                return;}
+            if (_n == N) {
+                // args may refer to an inline element, so build the new one before the move
+                value_type x(std::forward<Args>(args)...);
+                spill();
+                _d.emplace_back(std::move(x));
+                return;}
+            allocator_type a = _d.get_allocator();
+            traits::construct(a, slot(_n), std::forward<Args>(args)...);
+            ++_n;}
+
+        /**
+         * constructs an element from args ahead of the first element
+         */
+        template <typename... Args>
+        void emplace_front (Args&&... args) {
+            if (_spilled) {
+                _d.emplace_front(std::forward<Args>(args)...);
+                return;}
+            if (_n == N) {
+                value_type x(std::forward<Args>(args)...);
+                spill();
+                _d.emplace_front(std::move(x));
+                return;}
+            allocator_type a = _d.get_allocator();
+            traits::construct(a, slot(N - 1), std::forward<Args>(args)...);
+            _h = (_h + N - 1) % N;
+            ++_n;}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return size() == 0;}
+
+        // ---
+        // end
+        // ---
+
+        iterator end () {
+            return iterator(this, size());}
+
+        const_iterator end () const {
+            return const_iterator(this, size());}
+
+        // -----
+        // front
+        // -----
+
+        reference front () {
+            return _spilled ? _d.front() : *slot(0);}
+
+        const_reference front () const {
+            return const_cast<small_deque*>(this)->front();}
+
+        // -------------
+        // get_allocator
+        // -------------
+
+        allocator_type get_allocator () const {
+            return _d.get_allocator();}
+
+        // ---
+        // pop
+        // ---
+
+        void pop_back () {
+            if (_spilled) {
+                _d.pop_back();
+                return;}
+            allocator_type a = _d.get_allocator();
+            traits::destroy(a, slot(_n - 1));
+            --_n;}
+
+        void pop_front () {
+            if (_spilled) {
+                _d.pop_front();
+                return;}
+            allocator_type a = _d.get_allocator();
+            traits::destroy(a, slot(0));
+            _h = (_h + 1) % N;
+            --_n;}
+
+        // ----
+        // push
+        // ----
+
+        void push_back (const_reference v) {
+            emplace_back(v);}
+
+        void push_back (value_type&& v) {
+            emplace_back(std::move(v));}
+
+        void push_front (const_reference v) {
+            emplace_front(v);}
+
+        void push_front (value_type&& v) {
+            emplace_front(std::move(v));}
+
+        // -------------
+        // shrink_to_fit
+        // -------------
+
+        /**
+         * brings a spilled deque of at most N elements back inside the object and frees the my_deque
+         */
+        void shrink_to_fit () {
+            if (_spilled && (_d.size() <= N)) {
+                allocator_type a = _d.get_allocator();
+                try {
+                    for (; _n != _d.size(); ++_n)
+                        traits::construct(a, slot(_n), std::move_if_noexcept(_d[_n]));}
+                catch (...) {
+                    destroy_inline();
+                    throw;}
+                _d.clear();
+                _spilled = false;}
+            _d.shrink_to_fit();}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return _spilled ? _d.size() : _n;}
+
+        // -------
+        // spilled
+        // -------
+
+        /**
+         * returns true if the elements live in the my_deque instead of the object
+         */
+        bool spilled () const {
+            return _spilled;}
+
+        // ----
+        // swap
+        // ----
+
+        /**
+         * swaps the elements, inline ones are moved
+         */
+        void swap (small_deque& that) {
+            small_deque x(std::move(*this));
+            *this = std::move(that);
+            that  = std::move(x);}};
+
+#endif // DequeSmall_h
@@ -0,0 +1,815 @@
+// ---------------------------
+// projects/deque/DequeSpill.h
+// Copyright (C) 2014
+// Glenn P. Downing
+// ---------------------------
+
+#ifndef DequeSpill_h
+#define DequeSpill_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>     // max, min
+#include <atomic>        // atomic
+#include <cerrno>        // errno
+#include <cstddef>       // size_t
+#include <cstdint>       // uintptr_t
+#include <cstdlib>       // getenv
+#include <istream>       // istream
+#include <iterator>      // iterator_traits
+#include <mutex>         // lock_guard, mutex
+#include <new>           // bad_alloc
+#include <string>        // string
+#include <system_error>  // generic_category, system_error
+#include <type_traits>   // true_type
+#include <unordered_map> // unordered_map
+#include <utility>       // forward, move, swap
+#include <vector>        // vector
+
+#include <sys/mman.h>    // madvise, mmap, msync, munmap
+#include <unistd.h>      // close, ftruncate, mkstemp, sysconf, unlink
+
+#include "Deque.h"
+
+// ----------------
+// deque_spill_file
+// ----------------
+
+/**
+ * hands out cache line or page aligned pieces of an unlinked temporary file mapped shared into memory
+ * the pages are file pages, not anonymous ones, so under memory pressure the kernel writes
+ * them to the file and reclaims them instead of running out of memory,
+ * and faults them back in on the next access
+ * spill writes a range back and drops it from the process at once, prefetch asks for it back early
+ * the file grows by chunk_bytes at a time and pieces that are given back are reused by size
+ * thread safe
+ */
+class deque_spill_file {
+    public:
+        // every piece starts on a cache line, pieces of a page or more on a page
+        static const std::size_t alignment = 64;
+
+    private:
+        struct mapping {
+            void*       p;
+            std::size_t bytes;};
+
+        // ----
+        // data
+        // ----
+
+        mutable std::mutex _m;
+        int                _fd;
+        std::size_t        _chunk_bytes;
+        std::size_t        _file_bytes;
+        std::size_t        _page;
+        char*              _p;
+        std::size_t        _left;
+
+        // bytes handed to spill, for callers that watch how much is paged out
+        mutable std::atomic<std::size_t> _spilled;
+
+        std::vector<mapping>                        _maps;
+        // pieces given back, by size, kept outside the pieces so that they need not be touched
+        std::unordered_map<std::size_t, std::vector<void*> > _free;
+
+    private:
+        // -----
+        // round
+        // -----
+
+        static std::size_t round (std::size_t n, std::size_t m) {
+            return (n + m - 1) / m * m;}
+
+        // ------
+        // extend
+        // ------
+
+        /**
+         * grows the file by n bytes, n a multiple of the page size, and maps the new part
+         */
+        char* extend (std::size_t n) {
+            _maps.reserve(_maps.size() + 1);
+            if (ftruncate(_fd, _file_bytes + n) != 0)
+                throw std::bad_alloc();
+            void* p = mmap(0, n, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, _file_bytes);
+            if (p == MAP_FAILED)
+                throw std::bad_alloc();
+            _file_bytes += n;
+            mapping m = {p, n};
+            _maps.push_back(m);
+            return static_cast<char*>(p);}
+
+        // ----
+        // size
+        // ----
+
+        /**
+         * the bytes actually handed out for a request of n
+         */
+        std::size_t size (std::size_t n) const {
+            return round(n ? n : 1, (n < _page) ? std::size_t(alignment) : _page);}
+
+        // -----
+        // pages
+        // -----
+
+        /**
+         * shrinks [p, p + n) to the whole pages inside it, returns false if there are none
+         */
+        bool pages (void*& p, std::size_t& n) const {
+            std::uintptr_t b = round(reinterpret_cast<std::uintptr_t>(p), _page);
+            std::uintptr_t e = (reinterpret_cast<std::uintptr_t>(p) + n) / _page * _page;
+            if (b >= e)
+                return false;
+            p = reinterpret_cast<void*>(b);
+            n = e - b;
+            return true;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * a spill file in dir, or in $TMPDIR, or in /tmp, growing chunk_bytes at a time
+         * throws std::system_error if the file cannot be created
+         */
+        explicit deque_spill_file (const char* dir = 0, std::size_t chunk_bytes = std::size_t(64) << 20) :
+                _fd          (-1),
+                _chunk_bytes (0),
+                _file_bytes  (0),
+                _page        (std::size_t(sysconf(_SC_PAGESIZE))),
+                _p           (0),
+                _left        (0),
+                _spilled     (0) {
+            _chunk_bytes = round(chunk_bytes ? chunk_bytes : 1, _page);
+            if (!dir)
+                dir = std::getenv("TMPDIR");
+            std::string path = std::string((dir && *dir) ? dir : "/tmp") + "/deque_spill_XXXXXX";
+            std::vector<char> name(path.begin(), path.end());
+            name.push_back('\0');
+            _fd = mkstemp(&name[0]);
+            if (_fd < 0)
+                throw std::system_error(errno, std::generic_category(), "deque_spill_file");
+            // the file lives only as long as the descriptor
+            unlink(&name[0]);}
+
+        deque_spill_file (const deque_spill_file&) = delete;
+        deque_spill_file& operator = (const deque_spill_file&) = delete;
+
+        // ----------
+        // destructor
+        // ----------
+
+        /**
+         * unmaps and closes the file, which then disappears
+         */
+        ~deque_spill_file () {
+            for (std::size_t i = 0; i != _maps.size(); ++i)
+                munmap(_maps[i].p, _maps[i].bytes);
+            close(_fd);}
+
+        // --------
+        // allocate
+        // --------
+
+        /**
+         * n bytes of the file aligned to a cache line, or to a page if n is a page or more,
+         * so that a block can be spilled whole
+         * a request larger than a chunk gets a mapping of its own
+         */
+        void* allocate (std::size_t n) {
+            n = size(n);
+            std::lock_guard<std::mutex> l(_m);
+            std::vector<void*>& f = _free[n];
+            if (!f.empty()) {
+                void* p = f.back();
+                f.pop_back();
+                return p;}
+            if (n > _chunk_bytes)
+                return extend(n);
+            std::size_t skip = (n < _page) ? 0 : round(reinterpret_cast<std::uintptr_t>(_p), _page) - reinterpret_cast<std::uintptr_t>(_p);
+            if (skip + n > _left) {
+                _p    = extend(_chunk_bytes);
+                _left = _chunk_bytes;
+                skip  = 0;}
+            void* p = _p + skip;
+            _p    += skip + n;
+            _left -= skip + n;
+            return p;}
+
+        // ----------
+        // deallocate
+        // ----------
+
+        /**
+         * puts the n bytes at p on the free list for their size
+         * whole pages are dropped from the process, their contents no longer matter
+         */
+        void deallocate (void* p, std::size_t n) {
+            n = size(n);
+            if (n >= _page)
+                madvise(p, n, MADV_DONTNEED);
+            std::lock_guard<std::mutex> l(_m);
+            std::vector<void*>& f = _free[n];
+            try {
+                f.push_back(p);}
+            catch (...) {
+                // out of memory for the list, the piece stays unused in the file
+            }}
+
+        // ----------
+        // file_bytes
+        // ----------
+
+        /**
+         * returns the size of the file
+         */
+        std::size_t file_bytes () const {
+            std::lock_guard<std::mutex> l(_m);
+            return _file_bytes;}
+
+        // -------------
+        // spilled_bytes
+        // -------------
+
+        /**
+         * returns the bytes spill has dropped from memory so far, counting repeats
+         */
+        std::size_t spilled_bytes () const {
+            return _spilled.load(std::memory_order_relaxed);}
+
+        // --------
+        // prefetch
+        // --------
+
+        /**
+         * asks the kernel to read the pages of [p, p + n) back in ahead of use
+         */
+        void prefetch (void* p, std::size_t n) const {
+            if (pages(p, n))
+                madvise(p, n, MADV_WILLNEED);}
+
+        // -----
+        // spill
+        // -----
+
+        /**
+         * starts writing the whole pages of [p, p + n) to the file and drops them from the process
+         * the data stays valid, the next access reads it back
+         */
+        void spill (void* p, std::size_t n) const {
+            if (!pages(p, n))
+                return;
+            _spilled.fetch_add(n, std::memory_order_relaxed);
+            msync(p, n, MS_ASYNC);
+            // a shared file mapping keeps its data through MADV_DONTNEED,
+            // the pages stay in the page cache, where writeback cleans them and reclaim can take them
+            madvise(p, n, MADV_DONTNEED);}};
+
+// ---------------------
+// deque_spill_allocator
+// ---------------------
+
+/**
+ * an allocator that carves from a deque_spill_file
+ * copies share the file and follow the deque on copy, move and swap
+ */
+template <typename T>
+struct deque_spill_allocator {
+    static_assert(alignof(T) <= deque_spill_file::alignment, "deque_spill_allocator: T is over-aligned");
+
+    typedef T value_type;
+
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    template <typename U>
+    struct rebind {
+        typedef deque_spill_allocator<U> other;};
+
+    deque_spill_file* file;
+
+    explicit deque_spill_allocator (deque_spill_file& f) noexcept :
+            file (&f)
+        {}
+
+    template <typename U>
+    deque_spill_allocator (const deque_spill_allocator<U>& that) noexcept :
+            file (that.file)
+        {}
+
+    T* allocate (std::size_t n) {
+        return static_cast<T*>(file->allocate(n * sizeof(T)));}
+
+    void deallocate (T* p, std::size_t n) noexcept {
+        file->deallocate(p, n * sizeof(T));}};
+
+template <typename T, typename U>
+bool operator == (const deque_spill_allocator<T>& lhs, const deque_spill_allocator<U>& rhs) {
+    return lhs.file == rhs.file;}
+
+template <typename T, typename U>
+bool operator != (const deque_spill_allocator<T>& lhs, const deque_spill_allocator<U>& rhs) {
+    return !(lhs == rhs);}
+
+// -----------
+// spill_deque
+// -----------
+
+/**
+ * a my_deque whose blocks live in a spill file
+ * iterators and references point straight into blocks, so blocks never move;
+ * instead, once a block is more than resident / 2 blocks from its end of the deque,
+ * it is written to the file and dropped from memory, and the kernel pages it back on access
+ * popping prefetches the block resident / 2 blocks ahead, so the ends run at memory speed
+ * the my_deque is a private base, so every call that adds, removes or moves elements goes through
+ * this class, and bulk calls spill the blocks they leave in the cold middle in one pass
+ */
+template <typename T, std::size_t BS = deque_block_size<T>::value>
+class spill_deque : private my_deque<T, deque_spill_allocator<T>, BS> {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef my_deque<T, deque_spill_allocator<T>, BS> base_type;
+
+        typedef typename base_type::allocator_type      allocator_type;
+        typedef typename base_type::value_type          value_type;
+        typedef typename base_type::size_type           size_type;
+        typedef typename base_type::difference_type     difference_type;
+        typedef typename base_type::pointer             pointer;
+        typedef typename base_type::const_pointer       const_pointer;
+        typedef typename base_type::reference           reference;
+        typedef typename base_type::const_reference     const_reference;
+        typedef typename base_type::iterator            iterator;
+        typedef typename base_type::const_iterator      const_iterator;
+        typedef typename base_type::segment             segment;
+        typedef typename base_type::const_segment       const_segment;
+
+        // resident blocks kept when none is given
+        static const size_type default_resident_blocks = 64;
+
+        // blocks spilled or prefetched by one system call
+        static const size_type batch_blocks = 16;
+
+    public:
+        // -----------
+        // operator ==
+        // -----------
+
+        friend bool operator == (const spill_deque& lhs, const spill_deque& rhs) {
+            return lhs.base() == rhs.base();}
+
+        // ----------
+        // operator <
+        // ----------
+
+        friend bool operator < (const spill_deque& lhs, const spill_deque& rhs) {
+            return lhs.base() < rhs.base();}
+
+        // ----
+        // swap
+        // ----
+
+        friend void swap (spill_deque& lhs, spill_deque& rhs) noexcept {
+            lhs.swap(rhs);}
+
+    private:
+        // ----
+        // data
+        // ----
+
+        // blocks kept in memory, half at each end
+        size_type _resident;
+
+        // elements pushed or popped at each end since its last block boundary
+        size_type _front;
+        size_type _back;
+
+    private:
+        // ----
+        // base
+        // ----
+
+        const base_type& base () const {
+            return *this;}
+
+        // ----
+        // keep
+        // ----
+
+        size_type keep () const {
+            return (_resident / 2 + 1) * BS;}
+
+        // ----
+        // less
+        // ----
+
+        /**
+         * a - b, or 0 if b is larger
+         */
+        static size_type less (size_type a, size_type b) {
+            return (a > b) ? a - b : 0;}
+
+        // -------
+        // advise
+        // -------
+
+        /**
+         * spills, or prefetches, the whole blocks among the elements [b, e)
+         * a block straddling b or e is left to the neighbouring call
+         * blocks that are next to each other in the file go in one system call
+         */
+        void advise (size_type b, size_type e, bool out) {
+            deque_spill_file* f = this->get_allocator().file;
+            char*       p = 0;
+            std::size_t n = 0;
+            for (segment s : this->segments(this->begin() + b, this->begin() + e)) {
+                if (s.size != BS)
+                    continue;
+                char* q = reinterpret_cast<char*>(s.data);
+                if (q == p + n) {
+                    n += BS * sizeof(T);
+                    continue;}
+                if (n != 0)
+                    out ? f->spill(p, n) : f->prefetch(p, n);
+                p = q;
+                n = BS * sizeof(T);}
+            if (n != 0)
+                out ? f->spill(p, n) : f->prefetch(p, n);}
+
+        // ----
+        // cool
+        // ----
+
+        /**
+         * spills the whole blocks among the elements [b, e) that lie outside both hot ends
+         */
+        void cool (size_type b, size_type e) {
+            b = std::max(b, keep());
+            e = std::min(e, less(this->size(), keep()));
+            if (b < e)
+                advise(b, e, true);}
+
+        // ----
+        // warm
+        // ----
+
+        /**
+         * prefetches the hot end that a bulk removal has moved, a batch beyond it included
+         */
+        void warm (bool back) {
+            size_type n = std::min(this->size(), keep() + (batch_blocks + 1) * BS);
+            if (back)
+                advise(this->size() - n, this->size(), false);
+            else
+                advise(0, n, false);
+            (back ? _back : _front) = 0;}
+
+        // -----
+        // after
+        // -----
+
+        /**
+         * spills what a bulk change left in the middle
+         * elements [0, f) at the front and from index s - b on at the back were added or moved,
+         * so everything up to f + keep from the front and from s - b - keep on at the back has left its hot end
+         */
+        void after (size_type f, size_type b) {
+            cool(0, f + keep());
+            cool(less(this->size(), b + keep()), this->size());}
+
+        // -----------
+        // after_shift
+        // -----------
+
+        /**
+         * spills what an insert or erase at index i of a deque of s elements moved,
+         * my_deque shifts the shorter side
+         */
+        void after_shift (size_type i, size_type s) {
+            if (i < s / 2)
+                cool(0, i + 1 + keep());
+            else
+                cool(less(i, keep()), size());}
+
+        // ----------
+        // after_push
+        // ----------
+
+        /**
+         * every batch_blocks blocks pushed at an end, the blocks that have just moved out of the hot zone are spilled
+         */
+        void after_push (size_type& count, bool back) {
+            if ((++count < batch_blocks * BS) || (this->size() < 2 * keep() + (batch_blocks + 1) * BS))
+                return;
+            count = 0;
+            if (back)
+                advise(this->size() - keep() - (batch_blocks + 1) * BS, this->size() - keep(), true);
+            else
+                advise(keep(), keep() + (batch_blocks + 1) * BS, true);}
+
+        // ---------
+        // after_pop
+        // ---------
+
+        /**
+         * every batch_blocks blocks popped at an end, the blocks about to enter the hot zone are read back in
+         */
+        void after_pop (size_type& count, bool back) {
+            if ((++count < batch_blocks * BS) || (this->size() < 2 * keep() + (batch_blocks + 1) * BS))
+                return;
+            count = 0;
+            if (back)
+                advise(this->size() - keep() - (batch_blocks + 1) * BS, this->size() - keep(), false);
+            else
+                advise(keep(), keep() + (batch_blocks + 1) * BS, false);}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * an empty deque whose blocks come from f, keeping about resident blocks in memory
+         */
+        explicit spill_deque (deque_spill_file& f, size_type resident = default_resident_blocks) :
+                base_type (deque_spill_allocator<T>(f)),
+                _resident (resident < 2 ? 2 : resident),
+                _front    (0),
+                _back     (0)
+            {}
+
+        /**
+         * a copy in the same file, its middle spilled as it is built
+         */
+        spill_deque (const spill_deque& that) :
+                base_type (that.base()),
+                _resident (that._resident),
+                _front    (0),
+                _back     (0) {
+            cool(0, this->size());}
+
+        spill_deque (spill_deque&& that) noexcept :
+                base_type (std::move(static_cast<base_type&>(that))),
+                _resident (that._resident),
+                _front    (that._front),
+                _back     (that._back) {
+            that._front = 0;
+            that._back  = 0;}
+
+        // ----------
+        // operator =
+        // ----------
+
+        spill_deque& operator = (const spill_deque& rhs) {
+            base_type::operator=(rhs.base());
+            _front = _back = 0;
+            cool(0, this->size());
+            return *this;}
+
+        spill_deque& operator = (spill_deque&& rhs) {
+            base_type::operator=(std::move(static_cast<base_type&>(rhs)));
+            _front = rhs._front;
+            _back  = rhs._back;
+            return *this;}
+
+        // -------------------------
+        // element and block access
+        // -------------------------
+
+        // these neither add nor remove elements, so they need no bookkeeping
+        using base_type::operator[];
+        using base_type::at;
+        using base_type::back;
+        using base_type::begin;
+        using base_type::capacity_back;
+        using base_type::capacity_front;
+        using base_type::empty;
+        using base_type::end;
+        using base_type::for_each_segment;
+        using base_type::front;
+        using base_type::get_allocator;
+        using base_type::reserve_back;
+        using base_type::reserve_front;
+        using base_type::reset_stats;
+        using base_type::segments;
+        using base_type::serialize;
+        using base_type::shrink_to_fit;
+        using base_type::size;
+        using base_type::spare_blocks;
+        using base_type::stats;
+
+        // ------
+        // append
+        // ------
+
+        template <typename II>
+        void append (II b, II e) {
+            size_type s = size();
+            base_type::append(b, e);
+            after(0, size() - s);}
+
+        size_type append_from (std::istream& in, size_type n) {
+            size_type r = base_type::append_from(in, n);
+            after(0, r);
+            return r;}
+
+        // ------
+        // assign
+        // ------
+
+        template <typename II>
+        void assign (II b, II e) {
+            base_type::assign(b, e);
+            _front = _back = 0;
+            cool(0, size());}
+
+        // -----
+        // clear
+        // -----
+
+        void clear () {
+            base_type::clear();
+            _front = _back = 0;}
+
+        // -----------
+        // deserialize
+        // -----------
+
+        void deserialize (std::istream& in) {
+            base_type::deserialize(in);
+            _front = _back = 0;
+            cool(0, size());}
+
+        // -----------
+        // drain_front
+        // -----------
+
+        template <typename OI>
+        OI drain_front (size_type n, OI x) {
+            x = base_type::drain_front(n, x);
+            warm(false);
+            return x;}
+
+        // -------
+        // emplace
+        // -------
+
+        template <typename... Args>
+        iterator emplace (iterator i, Args&&... args) {
+            size_type s = size();
+            iterator  r = base_type::emplace(i, std::forward<Args>(args)...);
+            after_shift(r - begin(), s);
+            return r;}
+
+        // ------------
+        // emplace_back
+        // ------------
+
+        template <typename... Args>
+        void emplace_back (Args&&... args) {
+            base_type::emplace_back(std::forward<Args>(args)...);
+            after_push(_back, true);}
+
+        // -------------
+        // emplace_front
+        // -------------
+
+        template <typename... Args>
+        void emplace_front (Args&&... args) {
+            base_type::emplace_front(std::forward<Args>(args)...);
+            after_push(_front, false);}
+
+        // -----
+        // erase
+        // -----
+
+        iterator erase (iterator i) {
+            size_type s = size();
+            iterator  r = base_type::erase(i);
+            after_shift(r - begin(), s);
+            return r;}
+
+        // ------
+        // insert
+        // ------
+
+        iterator insert (iterator i, const_reference v) {
+            return emplace(i, v);}
+
+        iterator insert (iterator i, value_type&& v) {
+            return emplace(i, std::move(v));}
+
+        template <typename II, typename = typename std::iterator_traits<II>::iterator_category>
+        iterator insert (iterator i, II b, II e) {
+            size_type s = size();
+            iterator  r = base_type::insert(i, b, e);
+            size_type j = r - begin();
+            if (j < s / 2)
+                after(j + (size() - s), 0);
+            else
+                after(0, size() - j);
+            return r;}
+
+        // --------
+        // pop_back
+        // --------
+
+        void pop_back () {
+            base_type::pop_back();
+            after_pop(_back, true);}
+
+        size_type pop_back_n (size_type n) {
+            n = base_type::pop_back_n(n);
+            warm(true);
+            return n;}
+
+        // ---------
+        // pop_front
+        // ---------
+
+        void pop_front () {
+            base_type::pop_front();
+            after_pop(_front, false);}
+
+        size_type pop_front_n (size_type n) {
+            n = base_type::pop_front_n(n);
+            warm(false);
+            return n;}
+
+        // -------
+        // prepend
+        // -------
+
+        template <typename II>
+        void prepend (II b, II e) {
+            size_type s = size();
+            base_type::prepend(b, e);
+            after(size() - s, 0);}
+
+        // ---------
+        // push_back
+        // ---------
+
+        void push_back (const value_type& v) {
+            emplace_back(v);}
+
+        void push_back (value_type&& v) {
+            emplace_back(std::move(v));}
+
+        // ----------
+        // push_front
+        // ----------
+
+        void push_front (const value_type& v) {
+            emplace_front(v);}
+
+        void push_front (value_type&& v) {
+            emplace_front(std::move(v));}
+
+        // ---------------
+        // resident_blocks
+        // ---------------
+
+        /**
+         * returns the number of blocks kept in memory
+         */
+        size_type resident_blocks () const {
+            return _resident;}
+
+        /**
+         * sets the number of blocks kept in memory, taking effect as the ends move
+         */
+        void resident_blocks (size_type n) {
+            _resident = (n < 2) ? 2 : n;}
+
+        // ------
+        // resize
+        // ------
+
+        void resize (size_type s, const_reference v = value_type()) {
+            size_type t = size();
+            base_type::resize(s, v);
+            if (s > t)
+                after(0, s - t);
+            else if (s < t)
+                warm(true);}
+
+        // ----
+        // swap
+        // ----
+
+        void swap (spill_deque& that) noexcept {
+            base_type::swap(that);
+            std::swap(_resident, that._resident);
+            std::swap(_front,    that._front);
+            std::swap(_back,     that._back);}};
+
+#endif // DequeSpill_h
@@ -0,0 +1,243 @@
+// ---------------------------
+// projects/deque/DequeSpsc.h
+// Copyright (C) 2014
+// Glenn P. Downing
+// ---------------------------
+
+#ifndef DequeSpsc_h
+#define DequeSpsc_h
+
+// --------
+// includes
+// --------
+
+#include <atomic>      // atomic, memory_order
+#include <cstddef>     // size_t
+#include <memory>      // allocator, allocator_traits
+#include <type_traits> // aligned_storage
+#include <utility>     // forward, move
+
+#include "Deque.h"
+
+// ----------------
+// spsc_block_queue
+// ----------------
+
+/**
+ * a FIFO for exactly one producer thread and one consumer thread
+ * elements live in a chain of blocks of BS elements, like the blocks of my_deque
+ * the producer only writes the tail of the chain and the consumer only reads the head,
+ * and they meet through two atomics: the count pushed and the block the consumer is in
+ * blocks the consumer has left are handed back to the producer for reuse,
+ * so a queue in steady state does not allocate
+ * push and try_pop are wait-free except when push needs a fresh block
+ */
+template < typename T, typename A = std::allocator<T>, std::size_t BS = deque_block_size<T>::value >
+class spsc_block_queue {
+    static_assert(BS > 0, "spsc_block_queue: block size must be positive");
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef A           allocator_type;
+        typedef T           value_type;
+        typedef std::size_t size_type;
+
+    private:
+        // -----
+        // block
+        // -----
+
+        struct block {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type data[BS];
+            std::atomic<block*> next;};
+
+        typedef typename std::allocator_traits<A>::template rebind_alloc<block> block_allocator;
+        typedef std::allocator_traits<A>                                        traits;
+        typedef std::allocator_traits<block_allocator>                          block_traits;
+
+    private:
+        // ----
+        // data
+        // ----
+
+        allocator_type  _a;
+        block_allocator _ba;
+
+        // producer side
+        // _first is the oldest block in the chain, the ones from _first up to _head can be reused
+        alignas(64) block* _first;
+        block*             _tail;
+        size_type          _tail_index;
+        size_type          _pushed_local;
+
+        // consumer side
+        alignas(64) block* _head;
+        size_type          _head_index;
+        size_type          _popped_local;
+        size_type          _pushed_cache;
+
+        // shared
+        alignas(64) std::atomic<size_type> _pushed;
+        alignas(64) std::atomic<size_type> _popped;
+        alignas(64) std::atomic<block*>    _head_shared;
+
+    private:
+        // ----
+        // slot
+        // ----
+
+        static T* slot (block* b, size_type i) {
+            return reinterpret_cast<T*>(&b->data[i]);}
+
+        // ---------
+        // new_block
+        // ---------
+
+        /**
+         * a block the consumer is done with, or a fresh one
+         */
+        block* new_block () {
+            block* b;
+            if (_first != _head_shared.load(std::memory_order_acquire)) {
+                b = _first;
+                _first = _first->next.load(std::memory_order_relaxed);}
+            else
+                b = block_traits::allocate(_ba, 1);
+            b->next.store(0, std::memory_order_relaxed);
+            return b;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * an empty queue holding one block
+         */
+        explicit spsc_block_queue (const allocator_type& a = allocator_type()) :
+                _a            (a),
+                _ba           (a),
+                _first        (0),
+                _tail         (0),
+                _tail_index   (0),
+                _pushed_local (0),
+                _head         (0),
+                _head_index   (0),
+                _popped_local (0),
+                _pushed_cache (0),
+                _pushed       (0),
+                _popped       (0),
+                _head_shared  (0) {
+            _first = _tail = _head = new_block();
+            _head_shared.store(_head, std::memory_order_relaxed);}
+
+        spsc_block_queue (const spsc_block_queue&) = delete;
+        spsc_block_queue& operator = (const spsc_block_queue&) = delete;
+
+        // ----------
+        // destructor
+        // ----------
+
+        /**
+         * destroys what is left and frees every block
+         * neither thread may be using the queue
+         */
+        ~spsc_block_queue () {
+            block*    b = _head;
+            size_type i = _head_index;
+            for (size_type n = _pushed.load(std::memory_order_acquire) - _popped_local; n != 0; --n, ++i) {
+                if (i == BS) {
+                    b = b->next.load(std::memory_order_relaxed);
+                    i = 0;}
+                traits::destroy(_a, slot(b, i));}
+            while (_first) {
+                block* b = _first;
+                _first = b->next.load(std::memory_order_relaxed);
+                block_traits::deallocate(_ba, b, 1);}}
+
+        // -------
+        // emplace
+        // -------
+
+        /**
+         * producer only, constructs an element from args at the back
+         */
+        template <typename... Args>
+        void emplace (Args&&... args) {
+            if (_tail_index == BS) {
+                block* b = new_block();
+                // published to the consumer by the release store of _pushed below
+                _tail->next.store(b, std::memory_order_relaxed);
+                _tail = b;
+                _tail_index = 0;}
+            traits::construct(_a, slot(_tail, _tail_index), std::forward<Args>(args)...);
+            ++_tail_index;
+            _pushed.store(++_pushed_local, std::memory_order_release);}
+
+        // ----
+        // push
+        // ----
+
+        /**
+         * producer only, adds a copy of v at the back
+         */
+        void push (const value_type& v) {
+            emplace(v);}
+
+        /**
+         * producer only, moves v to the back
+         */
+        void push (value_type&& v) {
+            emplace(std::move(v));}
+
+        // -------
+        // try_pop
+        // -------
+
+        /**
+         * consumer only, moves the front element into x and removes it
+         * returns false if the queue is empty
+         */
+        bool try_pop (value_type& x) {
+            if (_popped_local == _pushed_cache) {
+                _pushed_cache = _pushed.load(std::memory_order_acquire);
+                if (_popped_local == _pushed_cache)
+                    return false;}
+            if (_head_index == BS) {
+                _head = _head->next.load(std::memory_order_relaxed);
+                _head_index = 0;
+                // the block left behind is empty, the producer may take it back
+                _head_shared.store(_head, std::memory_order_release);}
+            T* p = slot(_head, _head_index);
+            x = std::move(*p);
+            traits::destroy(_a, p);
+            ++_head_index;
+            _popped.store(++_popped_local, std::memory_order_release);
+            return true;}
+
+        // -----
+        // empty
+        // -----
+
+        /**
+         * consumer only, returns true if there is nothing to pop
+         */
+        bool empty () const {
+            return _popped_local == _pushed.load(std::memory_order_acquire);}
+
+        // -----------
+        // size_approx
+        // -----------
+
+        /**
+         * returns the number of elements, possibly stale by the time it returns
+         */
+        size_type size_approx () const {
+            size_type p = _popped.load(std::memory_order_acquire);
+            size_type q = _pushed.load(std::memory_order_acquire);
+            return (q > p) ? (q - p) : 0;}};
+
+#endif // DequeSpsc_h
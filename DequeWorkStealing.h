@@ -0,0 +1,241 @@
+// ----------------------------------
+// projects/deque/DequeWorkStealing.h
+// Copyright (C) 2014
+// Glenn P. Downing
+// ----------------------------------
+
+#ifndef DequeWorkStealing_h
+#define DequeWorkStealing_h
+
+// --------
+// includes
+// --------
+
+#include <atomic>      // atomic, atomic_thread_fence, memory_order
+#include <cstddef>     // ptrdiff_t, size_t
+#include <memory>      // allocator, allocator_traits
+#include <type_traits> // is_trivially_copyable
+
+// -------------------
+// work_stealing_deque
+// -------------------
+
+/**
+ * a Chase-Lev deque: one owner thread pushes and pops at the back, any thread steals from the front
+ * the elements sit in a power of two ring indexed by two ever growing counters, top and bottom
+ * push_back takes no lock and no read-modify-write, pop_back needs one fence
+ * and a compare-and-swap only when it races a thief for the last element
+ * a full ring is replaced by one twice as large, the way my_deque grows its map,
+ * but the old rings are kept until destruction because a thief may still be reading one
+ * T must be trivially copyable, a thief copies an element before it knows it has won it
+ */
+template < typename T, typename A = std::allocator<T> >
+class work_stealing_deque {
+    static_assert(std::is_trivially_copyable<T>::value, "work_stealing_deque: T must be trivially copyable");
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef A              allocator_type;
+        typedef T              value_type;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+    private:
+        // ----
+        // ring
+        // ----
+
+        struct ring {
+            std::atomic<T>* data;
+            size_type       mask;
+            ring*           previous;
+
+            std::atomic<T>& operator [] (difference_type i) {
+                return data[size_type(i) & mask];}};
+
+        typedef typename std::allocator_traits<A>::template rebind_alloc<std::atomic<T> > slot_allocator;
+        typedef typename std::allocator_traits<A>::template rebind_alloc<ring>            ring_allocator;
+        typedef std::allocator_traits<slot_allocator>                                      slot_traits;
+        typedef std::allocator_traits<ring_allocator>                                      ring_traits;
+
+    private:
+        // ----
+        // data
+        // ----
+
+        slot_allocator _sa;
+        ring_allocator _ra;
+
+        // thieves move _top, the owner moves _bottom, each on its own line
+        alignas(64) std::atomic<difference_type> _top;
+        alignas(64) std::atomic<difference_type> _bottom;
+        alignas(64) std::atomic<ring*>           _ring;
+
+    private:
+        // --------
+        // new_ring
+        // --------
+
+        /**
+         * a ring of s slots, s a power of two
+         */
+        ring* new_ring (size_type s, ring* previous) {
+            ring* r = ring_traits::allocate(_ra, 1);
+            r->data = slot_traits::allocate(_sa, s);
+            for (size_type i = 0; i != s; ++i)
+                slot_traits::construct(_sa, r->data + i);
+            r->mask     = s - 1;
+            r->previous = previous;
+            return r;}
+
+        // ----
+        // grow
+        // ----
+
+        /**
+         * copies [t, b) into a ring twice as large and publishes it
+         * only the owner calls grow, thieves keep reading r until they see the new one
+         */
+        ring* grow (ring* r, difference_type t, difference_type b) {
+            ring* s = new_ring(2 * (r->mask + 1), r);
+            for (difference_type i = t; i != b; ++i)
+                (*s)[i].store((*r)[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            _ring.store(s, std::memory_order_release);
+            return s;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * an empty deque with room for s elements before it grows, s rounded up to a power of two
+         */
+        explicit work_stealing_deque (size_type s = 64, const allocator_type& a = allocator_type()) :
+                _sa     (a),
+                _ra     (a),
+                _top    (0),
+                _bottom (0),
+                _ring   (0) {
+            size_type c = 1;
+            while (c < s)
+                c *= 2;
+            _ring.store(new_ring(c, 0), std::memory_order_relaxed);}
+
+        work_stealing_deque (const work_stealing_deque&) = delete;
+        work_stealing_deque& operator = (const work_stealing_deque&) = delete;
+
+        // ----------
+        // destructor
+        // ----------
+
+        /**
+         * frees the current ring and every one it replaced
+         */
+        ~work_stealing_deque () {
+            ring* r = _ring.load(std::memory_order_relaxed);
+            while (r) {
+                ring* p = r->previous;
+                slot_traits::deallocate(_sa, r->data, r->mask + 1);
+                ring_traits::deallocate(_ra, r, 1);
+                r = p;}}
+
+        // --------
+        // capacity
+        // --------
+
+        /**
+         * owner only, the number of elements that fit before the next growth
+         */
+        size_type capacity () const {
+            return _ring.load(std::memory_order_relaxed)->mask + 1;}
+
+        // -----
+        // empty
+        // -----
+
+        /**
+         * returns true if there was nothing to take, possibly stale by the time it returns
+         */
+        bool empty () const {
+            return size_approx() == 0;}
+
+        // --------
+        // pop_back
+        // --------
+
+        /**
+         * owner only, moves the newest element into x and removes it
+         * returns false if the deque is empty or a thief took the last element first
+         */
+        bool pop_back (value_type& x) {
+            difference_type b = _bottom.load(std::memory_order_relaxed) - 1;
+            ring*           r = _ring.load(std::memory_order_relaxed);
+            _bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            difference_type t = _top.load(std::memory_order_relaxed);
+            if (t > b) {
+                _bottom.store(b + 1, std::memory_order_relaxed);
+                return false;}
+            x = (*r)[b].load(std::memory_order_relaxed);
+            if (t < b)
+                return true;
+            // the last element, the owner and the thieves race for it on _top
+            bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return won;}
+
+        // ---------
+        // push_back
+        // ---------
+
+        /**
+         * owner only, adds v at the back, growing the ring when it is full
+         */
+        void push_back (const value_type& v) {
+            difference_type b = _bottom.load(std::memory_order_relaxed);
+            difference_type t = _top.load(std::memory_order_acquire);
+            ring*           r = _ring.load(std::memory_order_relaxed);
+            if (size_type(b - t) > r->mask)
+                r = grow(r, t, b);
+            (*r)[b].store(v, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            _bottom.store(b + 1, std::memory_order_relaxed);}
+
+        // -----------
+        // size_approx
+        // -----------
+
+        /**
+         * returns the number of elements, possibly stale by the time it returns
+         */
+        size_type size_approx () const {
+            difference_type b = _bottom.load(std::memory_order_relaxed);
+            difference_type t = _top.load(std::memory_order_relaxed);
+            return (b > t) ? size_type(b - t) : 0;}
+
+        // -----
+        // steal
+        // -----
+
+        /**
+         * any thread, moves the oldest element into x and removes it
+         * returns false if the deque is empty or another thread took that element first
+         */
+        bool steal (value_type& x) {
+            difference_type t = _top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            difference_type b = _bottom.load(std::memory_order_acquire);
+            if (t >= b)
+                return false;
+            ring*      r = _ring.load(std::memory_order_acquire);
+            value_type v = (*r)[t].load(std::memory_order_relaxed);
+            if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return false;
+            x = v;
+            return true;}};
+
+#endif // DequeWorkStealing_h
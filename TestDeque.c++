@@ -38,15 +38,20 @@
 // // --------
 
 #include <algorithm> // equal
+#include <cstdint>   // uint64_t
 #include <cstring>   // strcmp
 #include <deque>     // deque
-#include <sstream>   // ostringstream
-#include <stdexcept> // invalid_argument
+#include <iterator>  // istream_iterator
+#include <sstream>   // istringstream, ostringstream
+#include <stdexcept> // invalid_argument, runtime_error
 #include <string>    // ==
+#include <type_traits> // is_nothrow_default_constructible
+#include <vector>    // vector
 
 #include "gtest/gtest.h"
 
 #include "Deque.h"
+#include "DequeCountingAllocator.h"
 
 
 #define ALL_OF_IT       typedef typename TestFixture::deque_type      deque_type; \
@@ -83,12 +88,13 @@ typedef testing::Types<
             std::deque<int>,
             std::deque<double>,
             my_deque<int>,
-            my_deque<double> >
+            my_deque<double>,
+            my_deque<int,    std::allocator<int>,    4>,
+            my_deque<double, std::allocator<double>, 10> >
         my_types;
 
 TYPED_TEST_CASE(TestDeque, my_types);
 
-
 TYPED_TEST(TestDeque, back_1) {
     ALL_OF_IT
     using namespace std;
@@ -2692,3 +2698,764 @@ TYPED_TEST(TestDeque, erase_4) {
     ASSERT_EQ(d[0], 9);
     ASSERT_EQ(d[1], 11);
 }
+
+TYPED_TEST(TestDeque, blocks_1) {
+    ALL_OF_IT
+    using namespace std;
+    deque_type d;
+    for (int i = 0; i < 100; ++i)
+        d.push_back(i);
+
+    ASSERT_EQ(d.size(), 100);
+    for (int i = 0; i < 100; ++i)
+        ASSERT_EQ(d[i], i);
+}
+
+TYPED_TEST(TestDeque, blocks_2) {
+    ALL_OF_IT
+    using namespace std;
+    deque_type d;
+    for (int i = 0; i < 100; ++i)
+        d.push_front(i);
+
+    ASSERT_EQ(d.size(), 100);
+    ASSERT_EQ(d.front(), 99);
+    ASSERT_EQ(d.back(), 0);
+    for (int i = 0; i < 100; ++i)
+        ASSERT_EQ(d[i], 99 - i);
+}
+
+TYPED_TEST(TestDeque, blocks_3) {
+    ALL_OF_IT
+    using namespace std;
+    deque_type d(25, 3);
+    for (int i = 0; i < 20; ++i) {
+        d.push_front(i);
+        d.pop_back();}
+
+    ASSERT_EQ(d.size(), 25);
+    ASSERT_EQ(d.front(), 19);
+    ASSERT_EQ(d.back(), 3);
+    d.resize(7);
+    ASSERT_EQ(d.size(), 7);
+    ASSERT_EQ(d.back(), 13);
+    const deque_type e(d);
+    ASSERT_EQ(e, d);
+}
+
+TYPED_TEST(TestDeque, random_access_1) {
+    ALL_OF_IT
+    using namespace std;
+    deque_type d;
+    for (int i = 0; i < 50; ++i)
+        d.push_front(i);
+
+    ASSERT_EQ(d.end() - d.begin(), 50);
+    ASSERT_EQ(distance(d.begin(), d.end()), 50);
+    ASSERT_EQ(d.begin()[7], 42);
+    ASSERT_EQ(*(d.end() - 13), 12);
+    ASSERT_EQ((d.begin() + 37) - (d.begin() + 5), 32);
+    ASSERT_EQ(d.begin() < d.begin() + 20, true);
+    ASSERT_EQ(d.end() - 1 > d.begin() + 20, true);
+}
+
+TYPED_TEST(TestDeque, random_access_2) {
+    ALL_OF_IT
+    using namespace std;
+    deque_type d;
+    for (int i = 0; i < 60; ++i)
+        d.push_back((i * 37) % 60);
+    sort(d.begin(), d.end());
+
+    for (int i = 0; i < 60; ++i)
+        ASSERT_EQ(d[i], i);
+    const deque_type e(d);
+    ASSERT_EQ(lower_bound(e.begin(), e.end(), 45) - e.begin(), 45);
+    ASSERT_EQ(*(e.end() - 60), 0);
+}
+
+TYPED_TEST(TestDeque, move_1) {
+    ALL_OF_IT
+    using namespace std;
+    deque_type d(30, 4);
+    d.push_front(1);
+    deque_type e(std::move(d));
+
+    ASSERT_EQ(e.size(), 31);
+    ASSERT_EQ(e.front(), 1);
+    ASSERT_EQ(e.back(), 4);
+    d = e;
+    ASSERT_EQ(d, e);
+}
+
+TYPED_TEST(TestDeque, move_2) {
+    ALL_OF_IT
+    using namespace std;
+    deque_type d(5, 2);
+    deque_type e(40, 3);
+    d = std::move(e);
+
+    ASSERT_EQ(d.size(), 40);
+    ASSERT_EQ(d[39], 3);
+    e = d;
+    ASSERT_EQ(e.size(), 40);
+}
+
+TYPED_TEST(TestDeque, emplace_1) {
+    ALL_OF_IT
+    using namespace std;
+    deque_type d;
+    d.emplace_back(2);
+    d.emplace_front(1);
+    d.emplace_back(4);
+    d.emplace(d.begin() + 2, 3);
+
+    ASSERT_EQ(d.size(), 4);
+    for (int i = 0; i < 4; ++i)
+        ASSERT_EQ(d[i], i + 1);
+}
+
+TYPED_TEST(TestDeque, emplace_2) {
+    ALL_OF_IT
+    using namespace std;
+    deque_type d;
+    for (int i = 0; i < 40; ++i)
+        d.emplace(d.begin() + d.size() / 2, i);
+
+    ASSERT_EQ(d.size(), 40);
+    ASSERT_EQ(d.front(), 1);
+    ASSERT_EQ(d.back(), 0);
+    ASSERT_EQ(d[19], 39);
+    ASSERT_EQ(d[20], 38);
+}
+
+TEST(TestDequeString, move_1) {
+    my_deque<std::string> d;
+    std::string s(100, 'x');
+    d.push_back(std::move(s));
+    d.push_front(std::string(50, 'y'));
+    d.insert(d.begin() + 1, std::string(10, 'z'));
+    d.emplace_back(5, 'w');
+
+    ASSERT_EQ(d.size(), 4);
+    ASSERT_EQ(d[0], std::string(50, 'y'));
+    ASSERT_EQ(d[1], std::string(10, 'z'));
+    ASSERT_EQ(d[2], std::string(100, 'x'));
+    ASSERT_EQ(d[3], "wwwww");
+    my_deque<std::string> e(std::move(d));
+    ASSERT_EQ(e.size(), 4);
+    ASSERT_EQ(d.size(), 0);
+    d.push_back("again");
+    ASSERT_EQ(d.front(), "again");
+}
+
+TYPED_TEST(TestDeque, swap_4) {
+    ALL_OF_IT
+    using namespace std;
+    deque_type d(50, 1);
+    deque_type e(3, 2);
+    typename deque_type::iterator b = d.begin();
+    swap(d, e);
+
+    ASSERT_EQ(noexcept(swap(d, e)), true);
+    ASSERT_EQ(d.size(), 3);
+    ASSERT_EQ(e.size(), 50);
+    ASSERT_EQ(b == e.begin(), true);
+    ASSERT_EQ(d[2], 2);
+    ASSERT_EQ(e[49], 1);
+}
+
+TEST(TestDequeAllocation, lazy_1) {
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    counting_allocator<int>::live = 0;
+    {
+    deque_type d;
+    for (int i = 0; i < 1000; ++i)
+        d.push_back(i);
+    // the blocks holding the elements, the spare behind _e and the one ahead of _bi
+    ASSERT_EQ(counting_allocator<int>::live, 4 * (1000 / 4 + 2));
+    }
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+}
+
+TEST(TestDequeAllocation, lazy_2) {
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    counting_allocator<int>::live = 0;
+    {
+    deque_type d(40, 1);
+    ASSERT_EQ(counting_allocator<int>::live, 4 * (40 / 4 + 2));
+    for (int i = 0; i < 40; ++i)
+        d.push_front(i);
+    ASSERT_EQ(counting_allocator<int>::live, 4 * (80 / 4 + 2));
+    }
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+}
+
+TEST(TestDequeAllocation, lazy_3) {
+    // an empty deque allocates nothing, however it is made
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    static_assert(std::is_nothrow_default_constructible< my_deque<int> >::value, "my_deque() must be noexcept");
+    counting_allocator<int>::live  = 0;
+    counting_allocator<int*>::live = 0;
+    {
+    deque_type a;
+    deque_type b((counting_allocator<int>()));
+    deque_type c(0, 1);
+    deque_type d(a);
+    deque_type e(a.begin(), a.end());
+    deque_type f(std::move(a));
+    e = b;
+    f.clear();
+    f.resize(0);
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+    ASSERT_EQ(counting_allocator<int*>::live, 0);
+    f.push_back(1);
+    ASSERT_EQ(f.front(), 1);
+    ASSERT_EQ(counting_allocator<int*>::live, 3);
+    }
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+    ASSERT_EQ(counting_allocator<int*>::live, 0);
+}
+
+TEST(TestDequeAllocation, spare_1) {
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    counting_allocator<int>::live = 0;
+    {
+    deque_type d;
+    for (int i = 0; i < 1000; ++i)
+        d.push_back(i);
+    for (int i = 0; i < 1000; ++i)
+        d.pop_front();
+    // the empty block _e points into and two spares at each end,
+    // those behind _ei drained at the front and moved there for push_back
+    ASSERT_EQ(counting_allocator<int>::live, 4 * 5);
+    ASSERT_LE(d.capacity_front(), 3 + 1 * 4);
+    ASSERT_LE(d.capacity_back(),  3 + 2 * 4);
+    d.shrink_to_fit();
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+    d.push_back(7);
+    ASSERT_EQ(d.front(), 7);
+    }
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+}
+
+TEST(TestDequeAllocation, spare_2) {
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    counting_allocator<int>::live = 0;
+    {
+    deque_type d;
+    d.spare_blocks(0);
+    for (int i = 0; i < 1000; ++i)
+        d.push_front(i);
+    d.resize(10);
+    ASSERT_EQ(d.spare_blocks(), 0);
+    ASSERT_EQ(d.back(), 990);
+    d.shrink_to_fit();
+    d.push_front(-1);
+    d.push_back(-2);
+    ASSERT_EQ(d.size(), 12);
+    ASSERT_EQ(d.front(), -1);
+    ASSERT_EQ(d[1], 999);
+    ASSERT_EQ(d.back(), -2);
+    }
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+}
+
+TEST(TestDequeAllocation, spare_3) {
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    counting_allocator<int>::live = 0;
+    deque_type d;
+    for (int i = 0; i < 1000; ++i)
+        d.push_back(i);
+    d.spare_blocks(0);
+    d.resize(10);
+    // the block ahead of _bi and the three holding elements
+    ASSERT_EQ(counting_allocator<int>::live, 4 * 4);
+    d.shrink_to_fit();
+    ASSERT_EQ(counting_allocator<int>::live, 4 * 4);
+    for (int i = 0; i < 10; ++i)
+        ASSERT_EQ(d[i], i);
+}
+
+TEST(TestDequeAllocation, map_1) {
+    // the map comes from A rebound to block pointers, not from the global heap
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    counting_allocator<int*>::live = 0;
+    {
+    deque_type d;
+    ASSERT_EQ(counting_allocator<int*>::live, 0);
+    d.push_back(0);
+    ASSERT_EQ(counting_allocator<int*>::live, 3);
+    d.pop_back();
+    for (int i = 0; i < 1000; ++i)
+        d.push_front(i);
+    ASSERT_EQ(counting_allocator<int*>::live > 250, true);
+    d.clear();
+    d.shrink_to_fit();
+    ASSERT_EQ(counting_allocator<int*>::live, 0);
+    d.push_back(1);
+    }
+    ASSERT_EQ(counting_allocator<int*>::live, 0);
+}
+
+TEST(TestDequeAllocation, fifo_1) {
+    // a steady FIFO cycles its blocks and keeps its map
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    deque_type d;
+    for (int i = 0; i < 100; ++i)
+        d.push_back(i);
+    for (int i = 100; i < 200; ++i) {
+        d.push_back(i);
+        d.pop_front();}
+    long blocks = counting_allocator<int>::live;
+    long map    = counting_allocator<int*>::live;
+    for (int i = 200; i < 100000; ++i) {
+        d.push_back(i);
+        ASSERT_EQ(d.front(), i - 100);
+        d.pop_front();}
+    ASSERT_EQ(counting_allocator<int>::live, blocks);
+    ASSERT_EQ(counting_allocator<int*>::live, map);
+    ASSERT_EQ(d.size(), 100);
+    for (int i = 0; i < 100; ++i)
+        ASSERT_EQ(d[i], 99900 + i);
+}
+
+TEST(TestDequeAllocation, fifo_2) {
+    // and so does one running the other way
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    deque_type d;
+    for (int i = 0; i < 200; ++i) {
+        d.push_front(i);
+        if (i >= 100)
+            d.pop_back();}
+    long blocks = counting_allocator<int>::live;
+    long map    = counting_allocator<int*>::live;
+    for (int i = 200; i < 100000; ++i) {
+        d.push_front(i);
+        ASSERT_EQ(d.back(), i - 100);
+        d.pop_back();}
+    ASSERT_EQ(counting_allocator<int>::live, blocks);
+    ASSERT_EQ(counting_allocator<int*>::live, map);
+    for (int i = 0; i < 100; ++i)
+        ASSERT_EQ(d[i], 99999 - i);
+}
+
+TEST(TestDequeAllocation, stats_1) {
+    // with the default policy the counters are not kept, and take no room
+    typedef my_deque<int, std::allocator<int>, 4>                       plain_deque;
+    typedef my_deque<int, std::allocator<int>, 4, deque_counting_stats> stats_deque;
+    ASSERT_EQ((std::is_same<plain_deque::stats_policy, deque_no_stats>::value), true);
+    ASSERT_LT(sizeof(plain_deque), sizeof(stats_deque));
+    ASSERT_EQ(sizeof(plain_deque) % sizeof(void*), 0);
+    ASSERT_EQ(sizeof(plain_deque), sizeof(stats_deque) - sizeof(deque_counting_stats));
+    plain_deque d;
+    for (int i = 0; i < 100; ++i)
+        d.push_back(i);
+    d.erase(d.begin() + 50);
+    d.reset_stats();
+    ASSERT_EQ(d.stats().block_allocations, 0);
+    ASSERT_EQ(d.stats().elements_shifted, 0);
+    ASSERT_EQ(d.stats().peak_size, 0);
+}
+
+TEST(TestDequeAllocation, reserve_1) {
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    deque_type d;
+    d.push_back(0);
+    d.reserve_back(1000);
+    ASSERT_EQ(d.capacity_back() >= 1000, true);
+    long blocks = counting_allocator<int>::live;
+    long map    = counting_allocator<int*>::live;
+    for (int i = 1; i <= 1000; ++i)
+        d.push_back(i);
+    ASSERT_EQ(counting_allocator<int>::live, blocks);
+    ASSERT_EQ(counting_allocator<int*>::live, map);
+    ASSERT_EQ(d.size(), 1001);
+    ASSERT_EQ(d.back(), 1000);
+}
+
+TEST(TestDequeAllocation, reserve_2) {
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    deque_type d;
+    d.reserve_front(1000);
+    ASSERT_EQ(d.capacity_front() >= 1000, true);
+    long blocks = counting_allocator<int>::live;
+    long map    = counting_allocator<int*>::live;
+    for (int i = 1; i <= 1000; ++i)
+        d.push_front(i);
+    ASSERT_EQ(counting_allocator<int>::live, blocks);
+    ASSERT_EQ(counting_allocator<int*>::live, map);
+    ASSERT_EQ(d.front(), 1000);
+    ASSERT_EQ(d.back(), 1);
+}
+
+TEST(TestDequeAllocation, reserve_3) {
+    // the capacities are exact, one more push allocates
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    deque_type d;
+    ASSERT_EQ(d.capacity_front(), 0);
+    ASSERT_EQ(d.capacity_back(), 0);
+    d.push_back(0);
+    ASSERT_EQ(d.capacity_back(), 2);
+    for (std::size_t n = 0; n != 12; ++n) {
+        deque_type e;
+        e.push_back(1);
+        e.push_front(0);
+        e.reserve_back(n);
+        e.reserve_front(n);
+        std::size_t cb = e.capacity_back();
+        std::size_t cf = e.capacity_front();
+        ASSERT_EQ(cb >= n, true);
+        ASSERT_EQ(cf >= n, true);
+        long blocks = counting_allocator<int>::live;
+        for (std::size_t i = 0; i != cb; ++i)
+            e.push_back(2);
+        for (std::size_t i = 0; i != cf; ++i)
+            e.push_front(-1);
+        ASSERT_EQ(counting_allocator<int>::live, blocks);
+        ASSERT_EQ(e.capacity_back(), 0);
+        ASSERT_EQ(e.capacity_front(), 0);
+        e.push_back(3);
+        e.push_front(-2);
+        ASSERT_EQ(counting_allocator<int>::live, blocks + 8);}
+}
+
+TEST(TestDequeAllocation, reserve_4) {
+    // an order book pushes and pops at both ends, the reserve holds through it
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    deque_type d;
+    for (int i = 0; i < 100; ++i)
+        d.push_back(i);
+    d.reserve_back(1000);
+    d.reserve_front(200);
+    long allocations = counting_allocator<int>::calls;
+    long map         = counting_allocator<int*>::calls;
+    for (int i = 0; i < 1000; ++i) {
+        d.push_back(i);
+        if (i % 2 == 0)
+            d.pop_front();
+        if (i % 5 == 0)
+            d.push_front(-i);
+        if (i % 7 == 0)
+            d.pop_back();}
+    ASSERT_EQ(counting_allocator<int>::calls, allocations);
+    ASSERT_EQ(counting_allocator<int*>::calls, map);
+    ASSERT_EQ(d.size(), 100 + 1000 - 500 + 200 - 143);
+    // the reserve is used up, so pops give the blocks back again
+    d.clear();
+    ASSERT_LE(d.capacity_back(), 3 + 2 * 4);
+    ASSERT_LE(d.capacity_front(), 3 + 1 * 4);
+    d.reserve_back(100);
+    d.shrink_to_fit();
+    ASSERT_EQ(d.capacity_back(), 0);
+}
+
+TEST(TestDequeRange, range_1) {
+    int a[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    my_deque<int, std::allocator<int>, 4> d(a, a + 11);
+    ASSERT_EQ(d.size(), 11);
+    ASSERT_EQ(std::equal(d.begin(), d.end(), a), true);
+    d.assign(a + 5, a + 8);
+    ASSERT_EQ(d.size(), 3);
+    ASSERT_EQ(d[0], 6);
+    ASSERT_EQ(d[2], 8);
+    d.assign(a, a + 11);
+    ASSERT_EQ(std::equal(d.begin(), d.end(), a), true);
+}
+
+TEST(TestDequeRange, range_2) {
+    int a[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    my_deque<int, std::allocator<int>, 4> d;
+    d.append(a + 6, a + 11);
+    d.prepend(a, a + 3);
+    d.insert(d.begin() + 3, a + 3, a + 6);
+    ASSERT_EQ(d.size(), 11);
+    ASSERT_EQ(std::equal(d.begin(), d.end(), a), true);
+    for (int i = 0; i < 10; ++i)
+        d.prepend(a, a + 11);
+    ASSERT_EQ(d.size(), 121);
+    for (int i = 0; i < 121; ++i)
+        ASSERT_EQ(d[i], a[i % 11]);
+}
+
+TEST(TestDequeRange, range_3) {
+    std::istringstream in("4 5 6");
+    my_deque<double, std::allocator<double>, 4> d(3, 7);
+    d.prepend(std::istream_iterator<double>(in), std::istream_iterator<double>());
+    ASSERT_EQ(d.size(), 6);
+    ASSERT_EQ(d[0], 4);
+    ASSERT_EQ(d[2], 6);
+    ASSERT_EQ(d[3], 7);
+    std::istringstream in2("1 2");
+    d.assign(std::istream_iterator<double>(in2), std::istream_iterator<double>());
+    ASSERT_EQ(d.size(), 2);
+    ASSERT_EQ(d.back(), 2);
+    my_deque<double, std::allocator<double>, 4> e(d.begin(), d.end());
+    ASSERT_EQ(e, d);
+}
+
+TYPED_TEST(TestDeque, shift_1) {
+    ALL_OF_IT
+    using namespace std;
+    deque_type d;
+    std::deque<value_type> x;
+    for (int i = 0; i < 30; ++i) {
+        d.insert(d.begin() + (i * 7) % (d.size() + 1), i);
+        x.insert(x.begin() + (i * 7) % (x.size() + 1), i);}
+    ASSERT_EQ(equal(d.begin(), d.end(), x.begin()), true);
+    while (d.size() > 3) {
+        d.erase(d.begin() + d.size() / 2);
+        x.erase(x.begin() + x.size() / 2);}
+    ASSERT_EQ(equal(d.begin(), d.end(), x.begin()), true);
+    deque_type e(d);
+    e = d;
+    ASSERT_EQ(e, d);
+}
+
+TEST(TestDequeString, shift_1) {
+    my_deque<std::string, std::allocator<std::string>, 4> d;
+    std::deque<std::string> x;
+    for (int i = 0; i < 30; ++i) {
+        std::string s(i + 20, char('a' + i % 26));
+        d.insert(d.begin() + (i * 7) % (d.size() + 1), s);
+        x.insert(x.begin() + (i * 7) % (x.size() + 1), s);}
+    ASSERT_EQ(std::equal(d.begin(), d.end(), x.begin()), true);
+    for (int i = 0; i < 20; ++i) {
+        d.erase(d.begin() + (i * 3) % d.size());
+        x.erase(x.begin() + (i * 3) % x.size());}
+    ASSERT_EQ(std::equal(d.begin(), d.end(), x.begin()), true);
+    my_deque<std::string, std::allocator<std::string>, 4> e(3, "z");
+    e = d;
+    ASSERT_EQ(e, d);
+}
+
+// -------
+// counted
+// -------
+
+// int wrapper that tallies move assignments
+struct counted {
+    static int moves;
+    int v;
+    counted (int v = 0) : v (v) {}
+    counted (const counted&) = default;
+    counted& operator = (const counted&) = default;
+    counted& operator = (counted&& that) {
+        ++moves;
+        v = that.v;
+        return *this;}};
+
+int counted::moves = 0;
+
+TEST(TestDequeShift, shorter_1) {
+    my_deque<counted, std::allocator<counted>, 8> d;
+    for (int i = 0; i < 1000; ++i)
+        d.push_back(i);
+    counted::moves = 0;
+    d.insert(d.begin() + 3, counted(-1));
+    ASSERT_LE(counted::moves, 4);
+    d.insert(d.end() - 3, counted(-2));
+    ASSERT_LE(counted::moves, 8);
+    d.erase(d.begin() + 2);
+    d.erase(d.end() - 2);
+    ASSERT_LE(counted::moves, 14);
+    ASSERT_EQ(d.size(), 1000);
+    ASSERT_EQ(d[2].v, -1);
+    ASSERT_EQ(d[997].v, -2);
+    ASSERT_EQ(d[1].v, 1);
+    ASSERT_EQ(d[3].v, 3);
+    ASSERT_EQ(d[999].v, 999);
+}
+
+TEST(TestDequeSegment, segment_1) {
+    typedef my_deque<int, std::allocator<int>, 4> deque_type;
+    deque_type d;
+    for (int i = 0; i < 20; ++i)
+        d.push_back(i);
+    d.push_front(-1);
+    int sum   = 0;
+    int count = 0;
+    for (deque_type::segment s : d.segments()) {
+        ASSERT_LE(s.size, 4);
+        for (int* p = s.begin(); p != s.end(); ++p)
+            sum += *p;
+        ++count;}
+    ASSERT_EQ(sum, 189);
+    // one element in the front block, then five full blocks
+    ASSERT_EQ(count, 6);
+}
+
+TEST(TestDequeSegment, segment_2) {
+    typedef my_deque<int, std::allocator<int>, 4> deque_type;
+    deque_type d;
+    for (int i = 0; i < 20; ++i)
+        d.push_back(i);
+    const deque_type& c = d;
+    std::vector<std::size_t> sizes;
+    for (deque_type::const_segment s : c.segments(c.begin() + 2, c.end() - 3))
+        sizes.push_back(s.size);
+    ASSERT_EQ(sizes.size(), 5);
+    ASSERT_EQ(sizes[0], 2);
+    ASSERT_EQ(sizes[4], 1);
+    int n = 0;
+    d.for_each_segment(d.begin() + 5, d.begin() + 6, [&] (int* p, std::size_t k) {
+        n += k;
+        *p = 100;});
+    ASSERT_EQ(n, 1);
+    ASSERT_EQ(d[5], 100);
+    std::size_t total = 0;
+    c.for_each_segment([&] (const int*, std::size_t k) {total += k;});
+    ASSERT_EQ(total, 20);
+}
+
+TEST(TestDequeSerialize, serialize_1) {
+    typedef my_deque<int, std::allocator<int>, 4> deque_type;
+    deque_type d;
+    for (int i = 0; i < 50; ++i)
+        d.push_front(i);
+    std::ostringstream out;
+    d.serialize(out);
+    // a 24 byte header, then the elements
+    ASSERT_EQ(out.str().size(), 24 + 50 * sizeof(int));
+    deque_type e(3, 7);
+    std::istringstream in(out.str());
+    e.deserialize(in);
+    ASSERT_EQ(e == d, true);
+    deque_type f;
+    std::ostringstream empty;
+    f.serialize(empty);
+    std::istringstream again(empty.str());
+    e.deserialize(again);
+    ASSERT_EQ(e.empty(), true);
+}
+
+TEST(TestDequeSerialize, serialize_2) {
+    my_deque<double, std::allocator<double>, 10> d;
+    for (int i = 0; i < 25; ++i)
+        d.push_back(i / 2.0);
+    std::ostringstream out;
+    d.serialize(out);
+    std::string s = out.str();
+    my_deque<double, std::allocator<double>, 10> e(2, 1.0);
+    // truncated, the deque is left as it was
+    std::istringstream cut(s.substr(0, s.size() - 3));
+    ASSERT_THROW(e.deserialize(cut), std::runtime_error);
+    ASSERT_EQ(e.size(), 2);
+    // another element size
+    std::istringstream other(s);
+    my_deque<int> f;
+    ASSERT_THROW(f.deserialize(other), std::runtime_error);
+    std::istringstream junk("not a deque at all, just some text");
+    ASSERT_THROW(e.deserialize(junk), std::runtime_error);
+    std::istringstream in(s);
+    e.deserialize(in);
+    ASSERT_EQ(e == d, true);
+}
+
+TEST(TestDequeSerialize, serialize_3) {
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    deque_type d;
+    for (int i = 0; i < 10; ++i)
+        d.push_back(i);
+    std::ostringstream out;
+    d.serialize(out);
+    // the header claims 2^40 elements, the stream holds 10
+    std::string s = out.str();
+    std::uint64_t count = std::uint64_t(1) << 40;
+    s.replace(16, sizeof(count), reinterpret_cast<const char*>(&count), sizeof(count));
+    counting_allocator<int>::live = 0;
+    {
+    deque_type e;
+    std::istringstream in(s);
+    ASSERT_THROW(e.deserialize(in), std::runtime_error);
+    ASSERT_EQ(e.empty(), true);
+    std::istringstream body(s.substr(24));
+    ASSERT_EQ(e.append_from(body, std::size_t(count)), 10);
+    ASSERT_EQ(e == d, true);
+    // blocks for what was read, not for what was claimed
+    ASSERT_LE(counting_allocator<int>::live, 4 * 6 + 64);
+    }
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+}
+
+TEST(TestDequeSerialize, append_from_1) {
+    my_deque<int, std::allocator<int>, 4> d;
+    d.push_back(-1);
+    int a[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    std::istringstream in(std::string(reinterpret_cast<const char*>(a), sizeof(a)));
+    ASSERT_EQ(d.append_from(in, 5), 5);
+    ASSERT_EQ(d.append_from(in, 10), 4);
+    ASSERT_EQ(d.size(), 10);
+    ASSERT_EQ(d[0], -1);
+    ASSERT_EQ(d[9], 9);
+}
+
+TEST(TestDequeBatch, pop_front_n_1) {
+    typedef my_deque<int, counting_allocator<int>, 4> deque_type;
+    counting_allocator<int>::live = 0;
+    {
+    deque_type d;
+    for (int i = 0; i < 100; ++i)
+        d.push_back(i);
+    d.pop_front();
+    ASSERT_EQ(d.pop_front_n(0), 0);
+    ASSERT_EQ(d.pop_front_n(2), 2);
+    ASSERT_EQ(d.front(), 3);
+    ASSERT_EQ(d.pop_front_n(50), 50);
+    ASSERT_EQ(d.size(), 47);
+    ASSERT_EQ(d.front(), 53);
+    ASSERT_EQ(d.back(), 99);
+    // the drained blocks went back at once, as popping them one at a time would
+    deque_type e;
+    for (int i = 0; i < 100; ++i)
+        e.push_back(i);
+    for (int i = 0; i < 53; ++i)
+        e.pop_front();
+    ASSERT_EQ(d == e, true);
+    long blocks = counting_allocator<int>::live;
+    e.clear();
+    e.shrink_to_fit();
+    ASSERT_EQ(2 * counting_allocator<int>::live, blocks);
+    ASSERT_EQ(d.pop_front_n(1000), 47);
+    ASSERT_EQ(d.empty(), true);
+    d.push_back(1);
+    d.push_front(0);
+    ASSERT_EQ(d[1], 1);
+    }
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+}
+
+TEST(TestDequeBatch, pop_back_n_1) {
+    my_deque<std::string, std::allocator<std::string>, 4> d;
+    for (int i = 0; i < 30; ++i)
+        d.push_front(std::string(40, char('a' + i % 26)));
+    ASSERT_EQ(d.pop_back_n(7), 7);
+    ASSERT_EQ(d.size(), 23);
+    ASSERT_EQ(d.back(), std::string(40, char('a' + 7)));
+    ASSERT_EQ(d.pop_back_n(23), 23);
+    ASSERT_EQ(d.empty(), true);
+    ASSERT_EQ(d.pop_back_n(1), 0);
+    my_deque<int> e;
+    ASSERT_EQ(e.pop_back_n(5), 0);
+    ASSERT_EQ(e.pop_front_n(5), 0);
+}
+
+TEST(TestDequeBatch, drain_front_1) {
+    my_deque<std::string, std::allocator<std::string>, 4> d;
+    for (int i = 0; i < 30; ++i)
+        d.push_back(std::to_string(i));
+    std::vector<std::string> v;
+    d.drain_front(11, std::back_inserter(v));
+    ASSERT_EQ(v.size(), 11);
+    ASSERT_EQ(v[10], "10");
+    ASSERT_EQ(d.size(), 19);
+    ASSERT_EQ(d.front(), "11");
+    std::string a[30];
+    std::string* p = d.drain_front(100, a);
+    ASSERT_EQ(p - a, 19);
+    ASSERT_EQ(a[18], "29");
+    ASSERT_EQ(d.empty(), true);
+    my_deque<int> e;
+    int b[1];
+    ASSERT_EQ(e.drain_front(3, b), b);
+}
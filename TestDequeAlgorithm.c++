@@ -0,0 +1,105 @@
+// // -------------------------------------
+// // projects/deque/TestDequeAlgorithm.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // -------------------------------------
+
+// /*
+// To compile the test:
+//     % g++ -pedantic -std=c++11 -Wall TestDequeAlgorithm.c++ -o TestDequeAlgorithm -lgtest -lgtest_main -lpthread
+
+// To run the test:
+//     % valgrind TestDequeAlgorithm
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <algorithm> // count, find, max_element, min_element
+#include <cstddef>   // size_t
+#include <numeric>   // accumulate
+
+#include "gtest/gtest.h"
+
+#include "DequeAlgorithm.h"
+
+// ------------------
+// TestDequeAlgorithm
+// ------------------
+
+template <typename D>
+struct TestDequeAlgorithm : testing::Test {
+    typedef D                      deque_type;
+    typedef typename D::value_type value_type;
+
+    // n values with a shape that puts the extremes and repeats away from the ends
+    static deque_type make (std::size_t n, std::size_t front) {
+        deque_type d;
+        for (std::size_t i = 0; i < n; ++i)
+            d.push_back(value_type(int((i * 7919) % 1009) - 500));
+        for (std::size_t i = 0; i < front; ++i)
+            d.push_front(value_type(int(i % 13)));
+        return d;}};
+
+typedef testing::Types<
+            my_deque<int>,
+            my_deque<double>,
+            my_deque<int,    std::allocator<int>,    4>,
+            my_deque<double, std::allocator<double>, 10>,
+            my_deque<long>,
+            my_deque<int,    std::allocator<int>,    8, deque_counting_stats> >
+        algorithm_types;
+
+TYPED_TEST_CASE(TestDequeAlgorithm, algorithm_types);
+
+TYPED_TEST(TestDequeAlgorithm, sum_1) {
+    typedef typename TestFixture::value_type value_type;
+    for (std::size_t n : {0, 1, 7, 9, 100, 5000}) {
+        const typename TestFixture::deque_type d = TestFixture::make(n, n % 5);
+        ASSERT_EQ(deque_sum(d), std::accumulate(d.begin(), d.end(), value_type()));
+        ASSERT_EQ(deque_accumulate(d, value_type(3)), std::accumulate(d.begin(), d.end(), value_type(3)));}
+}
+
+TYPED_TEST(TestDequeAlgorithm, min_max_1) {
+    for (std::size_t n : {1, 3, 8, 17, 100, 5000}) {
+        const typename TestFixture::deque_type d = TestFixture::make(n, 3);
+        ASSERT_EQ(deque_min(d), *std::min_element(d.begin(), d.end()));
+        ASSERT_EQ(deque_max(d), *std::max_element(d.begin(), d.end()));}
+}
+
+TYPED_TEST(TestDequeAlgorithm, count_1) {
+    typedef typename TestFixture::value_type value_type;
+    const typename TestFixture::deque_type d = TestFixture::make(5000, 11);
+    for (int v : {-500, 0, 7, 508, 1000})
+        ASSERT_EQ(deque_count(d, value_type(v)), std::size_t(std::count(d.begin(), d.end(), value_type(v))));
+}
+
+TYPED_TEST(TestDequeAlgorithm, find_1) {
+    typedef typename TestFixture::value_type value_type;
+    typename TestFixture::deque_type d = TestFixture::make(5000, 11);
+    const typename TestFixture::deque_type& c = d;
+    for (int v : {-500, 0, 7, 508, 1000}) {
+        ASSERT_EQ(deque_find(c, value_type(v)) == std::find(c.begin(), c.end(), value_type(v)), true);
+        ASSERT_EQ(deque_find(d, value_type(v)) == std::find(d.begin(), d.end(), value_type(v)), true);}
+}
+
+TEST(TestDequeKernels, scalar_1) {
+    int a[] = {5, -3, 9, 9, 0, 2, 9, -7, 4, 1, 6};
+    ASSERT_EQ(deque_scalar_kernels<int>::sum(a, 11, 1), 36);
+    ASSERT_EQ(deque_scalar_kernels<int>::min(a, 11, a[0]), -7);
+    ASSERT_EQ(deque_scalar_kernels<int>::max(a, 11, a[0]), 9);
+    ASSERT_EQ(deque_scalar_kernels<int>::count(a, 11, 9), 3);
+    ASSERT_EQ(deque_scalar_kernels<int>::find(a, 11, 0), 4);
+    ASSERT_EQ(deque_scalar_kernels<int>::find(a, 11, 8), 11);
+}
+
+TEST(TestDequeKernels, dispatched_1) {
+    double a[] = {5, -3, 9, 9, 0, 2, 9, -7, 4, 1, 6, 2.5, 9};
+    ASSERT_EQ(deque_kernels<double>::sum(a, 13, 1), 47.5);
+    ASSERT_EQ(deque_kernels<double>::min(a, 13, a[0]), -7);
+    ASSERT_EQ(deque_kernels<double>::max(a, 13, a[0]), 9);
+    ASSERT_EQ(deque_kernels<double>::count(a, 13, 9), 4);
+    ASSERT_EQ(deque_kernels<double>::find(a, 13, 2.5), 11);
+    ASSERT_EQ(deque_kernels<double>::find(a, 13, 8), 13);
+}
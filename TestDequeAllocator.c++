@@ -0,0 +1,106 @@
+// // -------------------------------------
+// // projects/deque/TestDequeAllocator.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // -------------------------------------
+
+// /*
+// To compile the test:
+//     % g++ -pedantic -std=c++11 -Wall TestDequeAllocator.c++ -o TestDequeAllocator -lgtest -lgtest_main -lpthread
+
+// To run the test:
+//     % valgrind TestDequeAllocator
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <cstddef> // size_t
+#include <cstdint> // uintptr_t
+#include <set>     // set
+
+#include "gtest/gtest.h"
+
+#include "Deque.h"
+#include "DequeAllocator.h"
+
+// true if p starts on an a byte boundary
+template <typename T>
+bool aligned (const T* p, std::size_t a) {
+    return reinterpret_cast<std::uintptr_t>(p) % a == 0;}
+
+TEST(TestDequeAllocator, aligned_1) {
+    deque_aligned_allocator<char> a;
+    for (std::size_t n = 1; n < 200; n += 7) {
+        char* p = a.allocate(n);
+        ASSERT_EQ(aligned(p, deque_cache_line), true);
+        a.deallocate(p, n);}
+    deque_aligned_allocator<double, deque_simd_width> b;
+    double* q = b.allocate(3);
+    ASSERT_EQ(aligned(q, deque_simd_width), true);
+    b.deallocate(q, 3);
+}
+
+TEST(TestDequeAllocator, aligned_2) {
+    // every block, so every segment after the first, starts on a cache line
+    my_deque<int, deque_aligned_allocator<int>, 10> d;
+    for (int i = 0; i < 1000; ++i)
+        d.push_front(i);
+    int k = 0;
+    for (my_deque<int, deque_aligned_allocator<int>, 10>::segment s : d.segments()) {
+        if (k++ != 0) {
+            ASSERT_EQ(aligned(s.data, deque_cache_line), true);}}
+    ASSERT_EQ(k > 90, true);
+    ASSERT_EQ(d[0], 999);
+    ASSERT_EQ(d[999], 0);
+}
+
+TEST(TestDequeAllocator, huge_1) {
+    deque_huge_page_region r(1 << 20);
+    std::set<void*> s;
+    for (int i = 0; i < 5000; ++i) {
+        void* p = r.allocate(100);
+        ASSERT_EQ(aligned(static_cast<char*>(p), deque_huge_page_region::alignment), true);
+        ASSERT_EQ(s.insert(p).second, true);}
+    // 5000 pieces of 128 bytes need one region of 2 MiB
+    ASSERT_EQ(r.mapped_bytes(), std::size_t(deque_huge_page_region::huge_page_bytes));
+    void* p = *s.begin();
+    r.deallocate(p, 100);
+    ASSERT_EQ(r.allocate(128), p);
+    // larger than a region, gets its own
+    void* q = r.allocate(5 << 20);
+    ASSERT_EQ(r.mapped_bytes(), 4 * std::size_t(deque_huge_page_region::huge_page_bytes));
+    static_cast<char*>(q)[(5 << 20) - 1] = 1;
+    r.deallocate(q, 5 << 20);
+    // giving back never allocates, so it never throws
+    ASSERT_EQ(noexcept(r.deallocate(q, 5 << 20)), true);
+    ASSERT_EQ(r.allocate(5 << 20), q);
+}
+
+TEST(TestDequeAllocator, huge_2) {
+    deque_huge_page_region r(4 << 20);
+    deque_huge_page_allocator<long> a(r);
+    {
+    my_deque<long, deque_huge_page_allocator<long> > d(a);
+    for (long i = 0; i < 300000; ++i)
+        d.push_back(i);
+    long s = 0;
+    for (long i = 0; i < 300000; i += 1000)
+        s += d.at(i);
+    ASSERT_EQ(s, 44850000);
+    my_deque<long, deque_huge_page_allocator<long> > e;
+    ASSERT_EQ(e.get_allocator().region, &deque_default_huge_page_region());
+    e = d;
+    ASSERT_EQ(e.get_allocator().region, &r);
+    ASSERT_EQ(e == d, true);
+    }
+    std::size_t m = r.mapped_bytes();
+    {
+    // the second deque reuses the blocks the first gave back
+    my_deque<long, deque_huge_page_allocator<long> > d(a);
+    for (long i = 0; i < 300000; ++i)
+        d.push_front(i);
+    }
+    ASSERT_EQ(r.mapped_bytes(), m);
+}
@@ -0,0 +1,171 @@
+// // ----------------------------------
+// // projects/deque/TestDequeMemory.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // ----------------------------------
+
+// /*
+// To compile the test:
+//     % g++ -pedantic -std=c++17 -Wall TestDequeMemory.c++ -o TestDequeMemory -lgtest -lgtest_main -lpthread
+
+// To run the test:
+//     % valgrind TestDequeMemory
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <cstddef>         // size_t
+#include <memory_resource> // memory_resource, new_delete_resource
+#include <string>          // pmr::string
+#include <utility>         // move
+
+#include "gtest/gtest.h"
+
+#include "DequeMemory.h"
+
+// ----------------
+// counting_resource
+// ----------------
+
+// forwards to new_delete_resource and tallies what is outstanding
+struct counting_resource : std::pmr::memory_resource {
+    long bytes;
+    long allocations;
+    long calls;
+
+    counting_resource () :
+            bytes       (0),
+            allocations (0),
+            calls       (0)
+        {}
+
+    void* do_allocate (std::size_t n, std::size_t a) override {
+        bytes += n;
+        ++allocations;
+        ++calls;
+        return std::pmr::new_delete_resource()->allocate(n, a);}
+
+    void do_deallocate (void* p, std::size_t n, std::size_t a) override {
+        bytes -= n;
+        --allocations;
+        std::pmr::new_delete_resource()->deallocate(p, n, a);}
+
+    bool do_is_equal (const std::pmr::memory_resource& that) const noexcept override {
+        return this == &that;}};
+
+TEST(TestDequeMemory, pmr_1) {
+    // blocks and map both come from the resource and all go back to it
+    counting_resource r;
+    {
+    pmr_deque<int, 4> d(&r);
+    ASSERT_EQ(d.get_allocator().resource(), &r);
+    for (int i = 0; i < 1000; ++i)
+        d.push_front(i);
+    ASSERT_EQ(r.bytes > long(1000 * sizeof(int) + 250 * sizeof(int*)), true);
+    ASSERT_EQ(d[0], 999);
+    }
+    ASSERT_EQ(r.bytes, 0);
+    ASSERT_EQ(r.allocations, 0);
+}
+
+TEST(TestDequeMemory, pmr_2) {
+    // polymorphic allocators do not propagate on copy assignment, move assignment or swap
+    counting_resource r;
+    counting_resource s;
+    {
+    pmr_deque<int, 4> x(&r);
+    pmr_deque<int, 4> y(&s);
+    for (int i = 0; i < 50; ++i)
+        x.push_back(i);
+    y = x;
+    ASSERT_EQ(y.get_allocator().resource(), &s);
+    ASSERT_EQ(y == x, true);
+    pmr_deque<int, 4> z(x);
+    ASSERT_EQ(z.get_allocator().resource(), std::pmr::get_default_resource());
+    pmr_deque<int, 4> w(std::move(x));
+    ASSERT_EQ(w.get_allocator().resource(), &r);
+    ASSERT_EQ(w.size(), 50);
+    // different resources, so the elements move one by one into blocks from s
+    long before = r.bytes;
+    y.clear();
+    y = std::move(w);
+    ASSERT_EQ(y.get_allocator().resource(), &s);
+    ASSERT_EQ(y.size(), 50);
+    ASSERT_EQ(y[49], 49);
+    ASSERT_EQ(w.empty(), true);
+    ASSERT_EQ(r.bytes <= before, true);
+    pmr_deque<int, 4> v(&s);
+    v.push_back(-1);
+    v.swap(y);
+    ASSERT_EQ(v.size(), 50);
+    ASSERT_EQ(y.front(), -1);
+    }
+    ASSERT_EQ(r.bytes, 0);
+    ASSERT_EQ(s.bytes, 0);
+}
+
+TEST(TestDequeMemory, pmr_3) {
+    // elements that take an allocator are built with the deque's
+    counting_resource r;
+    {
+    pmr_deque<std::pmr::string> d(&r);
+    d.emplace_back("a string long enough to need memory of its own");
+    d.push_front(std::pmr::string("another string long enough to need memory"));
+    ASSERT_EQ(d.front().get_allocator().resource(), &r);
+    ASSERT_EQ(d.back().get_allocator().resource(), &r);
+    d.resize(10);
+    ASSERT_EQ(d[9].get_allocator().resource(), &r);
+    }
+    ASSERT_EQ(r.bytes, 0);
+}
+
+TEST(TestDequeMemory, arena_1) {
+    counting_resource r;
+    {
+    deque_monotonic_arena arena(1024, &r);
+    {
+    pmr_deque<int, 16> d(&arena);
+    for (int i = 0; i < 10000; ++i)
+        d.push_back(i);
+    ASSERT_EQ(d[9999], 9999);
+    ASSERT_EQ(arena.used() >= 10000 * sizeof(int), true);
+    }
+    // the deque is gone but the arena keeps its chunks until release
+    ASSERT_EQ(r.allocations > 0, true);
+    long chunks = r.allocations;
+    arena.release();
+    ASSERT_EQ(r.bytes, 0);
+    ASSERT_EQ(arena.used(), 0);
+    pmr_deque<int, 16> e(&arena);
+    e.push_back(1);
+    ASSERT_EQ(r.allocations, 1);
+    ASSERT_EQ(chunks > 1, true);
+    }
+    ASSERT_EQ(r.bytes, 0);
+}
+
+TEST(TestDequeMemory, pool_1) {
+    // a deque that grows and drains reuses the pool's blocks
+    counting_resource r;
+    {
+    deque_block_pool<int, 8> pool(4, &r);
+    pmr_deque<int, 8> d(&pool);
+    for (int i = 0; i < 200; ++i)
+        d.push_back(i);
+    for (int i = 0; i < 200; ++i)
+        d.pop_front();
+    long calls = r.calls;
+    for (int k = 0; k < 10; ++k) {
+        for (int i = 0; i < 200; ++i)
+            d.push_back(i);
+        for (int i = 0; i < 200; ++i)
+            d.pop_front();}
+    // after warming up only the map may still go upstream
+    ASSERT_EQ(r.calls - calls < 10, true);
+    ASSERT_EQ(pool.free_blocks() > 0, true);
+    d.shrink_to_fit();
+    }
+    ASSERT_EQ(r.bytes, 0);
+}
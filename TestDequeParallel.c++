@@ -0,0 +1,126 @@
+// // ------------------------------------
+// // projects/deque/TestDequeParallel.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // ------------------------------------
+
+// /*
+// To compile the test:
+//     % g++ -pedantic -std=c++11 -Wall TestDequeParallel.c++ -o TestDequeParallel -lgtest -lgtest_main -lpthread
+
+// To run the test:
+//     % valgrind TestDequeParallel
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <atomic>    // atomic
+#include <cstddef>   // size_t
+#include <numeric>   // accumulate
+#include <stdexcept> // runtime_error
+#include <string>    // string
+
+#include "gtest/gtest.h"
+
+#include "DequeParallel.h"
+
+TEST(TestDequeThreadPool, run_1) {
+    deque_thread_pool pool(4);
+    ASSERT_EQ(pool.size(), 4);
+    std::vector<int> hits(1000);
+    for (int r = 0; r < 20; ++r)
+        pool.run(hits.size(), [&hits] (std::size_t i) {++hits[i];});
+    for (std::size_t i = 0; i != hits.size(); ++i)
+        ASSERT_EQ(hits[i], 20);
+}
+
+TEST(TestDequeThreadPool, run_2) {
+    deque_thread_pool pool(3);
+    std::atomic<int> n(0);
+    ASSERT_THROW(pool.run(50, [&n] (std::size_t i) {
+        ++n;
+        if (i == 17)
+            throw std::runtime_error("task");}), std::runtime_error);
+    ASSERT_EQ(n, 50);
+    pool.run(5, [&n] (std::size_t) {++n;});
+    ASSERT_EQ(n, 55);
+}
+
+TEST(TestDequeParallel, for_each_1) {
+    deque_thread_pool pool(4);
+    my_deque<int, std::allocator<int>, 8> d;
+    for (int i = 0; i < 1000; ++i)
+        d.push_front(i);
+    deque_parallel_for_each(d, [] (int& x) {x *= 2;}, pool);
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_EQ(d[i], 2 * (999 - i));
+    std::atomic<long> s(0);
+    const my_deque<int, std::allocator<int>, 8>& c = d;
+    deque_parallel_for_each(c, [&s] (const int& x) {s += x;}, pool);
+    ASSERT_EQ(s, 999000);
+}
+
+TEST(TestDequeParallel, transform_1) {
+    deque_thread_pool pool(4);
+    my_deque<double, std::allocator<double>, 16> d;
+    for (int i = 0; i < 1000; ++i)
+        d.push_back(i);
+    d.pop_front();
+    deque_parallel_transform(d, [] (double x) {return x + 0.5;}, pool);
+    ASSERT_EQ(d.front(), 1.5);
+    ASSERT_EQ(d.back(), 999.5);
+    my_deque<long, std::allocator<long>, 5> e(d.size());
+    deque_parallel_transform(d, e, [] (double x) {return long(2 * x);}, pool);
+    for (std::size_t i = 0; i != e.size(); ++i)
+        ASSERT_EQ(e[i], long(2 * i + 3));
+}
+
+TEST(TestDequeParallel, reduce_1) {
+    deque_thread_pool pool(4);
+    my_deque<int, std::allocator<int>, 8> d;
+    ASSERT_EQ(deque_parallel_reduce(d, 7L, pool), 7);
+    for (int i = 0; i < 1000; ++i)
+        d.push_back(i);
+    ASSERT_EQ(deque_parallel_reduce(d, 0L, pool), 499500);
+    // string concatenation is associative but not commutative
+    my_deque<std::string, std::allocator<std::string>, 4> s;
+    for (int i = 0; i < 100; ++i)
+        s.push_back(std::string(1, char('a' + i % 26)));
+    std::string x = deque_parallel_reduce(s, std::string(">"),
+        [] (const std::string& a, const std::string& b) {return a + b;}, pool);
+    ASSERT_EQ(x, std::accumulate(s.begin(), s.end(), std::string(">")));
+}
+
+TEST(TestDequeParallel, reduce_2) {
+    deque_thread_pool pool(4);
+    // the sum and every partial overflow int
+    my_deque<int, std::allocator<int>, 8> d(1000, 2000000000);
+    ASSERT_EQ(deque_parallel_reduce(d, 0LL, pool), 2000000000000LL);
+    ASSERT_EQ(deque_parallel_reduce(d, 1LL, [] (long long a, long long b) {return a + b;}, pool),
+              2000000000001LL);
+    // halves would be truncated by an int partial
+    my_deque<int, std::allocator<int>, 8> e(999, 1);
+    double h = deque_parallel_reduce(e, 0.0, 0.0,
+        [] (double a, int b) {return a + b / 2.0;},
+        [] (double a, double b) {return a + b;}, pool);
+    ASSERT_EQ(h, 499.5);
+    // fold and combine of different shapes, counting the odd elements
+    my_deque<int, std::allocator<int>, 8> f;
+    for (int i = 0; i < 1001; ++i)
+        f.push_back(i);
+    std::size_t odd = deque_parallel_reduce(f, std::size_t(0), std::size_t(0),
+        [] (std::size_t a, int b) {return a + (b % 2);},
+        [] (std::size_t a, std::size_t b) {return a + b;}, pool);
+    ASSERT_EQ(odd, 500);
+}
+
+TEST(TestDequeParallel, fill_1) {
+    my_deque<int, std::allocator<int>, 8> d(333, 1);
+    d.push_front(1);
+    deque_parallel_fill(d, 9);
+    ASSERT_EQ(d.size(), 334);
+    for (std::size_t i = 0; i != d.size(); ++i)
+        ASSERT_EQ(d[i], 9);
+}
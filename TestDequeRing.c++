@@ -0,0 +1,118 @@
+// // --------------------------------
+// // projects/deque/TestDequeRing.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // --------------------------------
+
+// /*
+// To compile the test:
+//     % g++ -pedantic -std=c++11 -Wall TestDequeRing.c++ -o TestDequeRing -lgtest -lgtest_main -lpthread
+
+// To run the test:
+//     % valgrind TestDequeRing
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <algorithm> // equal, sort
+#include <memory>    // allocator
+#include <numeric>   // accumulate
+#include <string>    // string
+#include <utility>   // move
+
+#include "gtest/gtest.h"
+
+#include "DequeRing.h"
+#include "DequeCountingAllocator.h"
+
+TEST(TestDequeRing, fail_1) {
+    // 10 elements over blocks of 4, so the ring ends inside its last block
+    ring_deque<int, deque_ring_fail, counting_allocator<int>, 4> d(10);
+    ASSERT_EQ(d.capacity(), 10);
+    counting_allocator<int>::calls  = 0;
+    counting_allocator<int*>::calls = 0;
+    for (int k = 0; k != 1000; ++k) {
+        for (int i = 0; i != 6; ++i)
+            ASSERT_EQ(d.push_back(i), true);
+        for (int i = 0; i != 4; ++i)
+            ASSERT_EQ(d.push_front(-i), true);
+        ASSERT_EQ(d.full(), true);
+        ASSERT_EQ(d.push_back(99), false);
+        ASSERT_EQ(d.push_front(99), false);
+        ASSERT_EQ(d.size(), 10);
+        ASSERT_EQ(d.front(), -3);
+        ASSERT_EQ(d.back(), 5);
+        ASSERT_EQ(d[4], 0);
+        for (int i = 0; i != 7; ++i)
+            d.pop_front();
+        ASSERT_EQ(d.front(), 3);
+        d.pop_back();
+        d.pop_back();
+        d.pop_back();
+        ASSERT_EQ(d.empty(), true);}
+    ASSERT_EQ(counting_allocator<int>::calls, 0);
+    ASSERT_EQ(counting_allocator<int*>::calls, 0);
+}
+
+TEST(TestDequeRing, overwrite_1) {
+    ring_deque<int, deque_ring_overwrite, std::allocator<int>, 4> d(6);
+    for (int i = 0; i != 20; ++i)
+        ASSERT_EQ(d.push_back(i), i < 6);
+    ASSERT_EQ(d.size(), 6);
+    for (int i = 0; i != 6; ++i)
+        ASSERT_EQ(d[i], 14 + i);
+    // a push at the front drops the last element
+    ASSERT_EQ(d.push_front(d.back()), false);
+    ASSERT_EQ(d.front(), 19);
+    ASSERT_EQ(d.back(), 18);
+    // and one at the back drops the first, which it may copy
+    ASSERT_EQ(d.push_back(d.front()), false);
+    ASSERT_EQ(d.front(), 14);
+    ASSERT_EQ(d.back(), 19);
+    ring_deque<int, deque_ring_overwrite> e(0);
+    ASSERT_EQ(e.push_back(1), false);
+    ASSERT_EQ(e.empty(), true);
+}
+
+TEST(TestDequeRing, iterator_1) {
+    ring_deque<int, deque_ring_fail, std::allocator<int>, 4> d(7);
+    // start the elements part way round the ring
+    for (int i = 0; i != 5; ++i) {
+        d.push_back(0);
+        d.pop_front();}
+    const int a[] = {5, 3, 7, 1, 6, 2, 4};
+    for (int i = 0; i != 7; ++i)
+        d.push_back(a[i]);
+    std::sort(d.begin(), d.end());
+    const ring_deque<int, deque_ring_fail, std::allocator<int>, 4>& c = d;
+    ASSERT_EQ(std::accumulate(c.begin(), c.end(), 0), 28);
+    for (int i = 0; i != 7; ++i)
+        ASSERT_EQ(c.at(i), i + 1);
+    ASSERT_EQ(c.end() - c.begin(), 7);
+    ASSERT_THROW(c.at(7), std::out_of_range);
+}
+
+TEST(TestDequeRing, copy_1) {
+    ring_deque<std::string, deque_ring_overwrite, std::allocator<std::string>, 2> x(3);
+    x.push_back("b");
+    x.push_back("c");
+    x.push_front("a");
+    x.push_back("d");
+    ring_deque<std::string, deque_ring_overwrite, std::allocator<std::string>, 2> y(x);
+    ASSERT_EQ(x == y, true);
+    ASSERT_EQ(y.front(), "b");
+    y.pop_back();
+    ASSERT_EQ(y < x, true);
+    ring_deque<std::string, deque_ring_overwrite, std::allocator<std::string>, 2> z(std::move(y));
+    ASSERT_EQ(y.capacity(), 0);
+    ASSERT_EQ(z.size(), 2);
+    swap(x, z);
+    ASSERT_EQ(x.size(), 2);
+    ASSERT_EQ(z.back(), "d");
+    x = z;
+    ASSERT_EQ(x == z, true);
+    z.clear();
+    ASSERT_EQ(z.capacity(), 3);
+}
@@ -0,0 +1,103 @@
+// // -------------------------------------
+// // projects/deque/TestDequeSerialize.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // -------------------------------------
+
+// /*
+// To compile the test:
+//     % g++ -pedantic -std=c++11 -Wall TestDequeSerialize.c++ -o TestDequeSerialize -lgtest -lgtest_main -lpthread
+
+// To run the test:
+//     % valgrind TestDequeSerialize
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <cstdint>   // uint64_t
+#include <cstdio>    // remove
+#include <fstream>   // ifstream
+#include <sstream>   // istringstream, ostringstream
+#include <stdexcept> // runtime_error
+#include <string>    // string
+
+#include <unistd.h>  // close, mkstemp
+
+#include "gtest/gtest.h"
+
+#include "DequeSerialize.h"
+
+TEST(TestDequeSerialize, reader_1) {
+    my_deque<long, std::allocator<long>, 8> d;
+    for (long i = 0; i < 100; ++i)
+        d.push_back(i * i);
+    std::ostringstream out;
+    d.serialize(out);
+    std::istringstream in(out.str());
+    deque_checkpoint_reader<long> r(in);
+    ASSERT_EQ(r.remaining(), 100);
+    // the live deque is used between pieces
+    my_deque<long, std::allocator<long>, 8> e;
+    e.push_back(-1);
+    while (!r.done()) {
+        r.read_into(e, 30);
+        e.push_back(-2);
+        e.pop_back();
+        e.pop_front();
+        e.push_front(-1);}
+    ASSERT_EQ(e.size(), 101);
+    ASSERT_EQ(e.front(), -1);
+    ASSERT_EQ(e.back(), 99 * 99);
+    ASSERT_EQ(std::equal(d.begin(), d.end(), e.begin() + 1), true);
+    ASSERT_EQ(r.read_into(e), 0);
+}
+
+TEST(TestDequeSerialize, reader_2) {
+    my_deque<int> d(1000, 3);
+    std::ostringstream out;
+    d.serialize(out);
+    std::string s = out.str();
+    std::istringstream cut(s.substr(0, s.size() - 400));
+    deque_checkpoint_reader<int> r(cut);
+    my_deque<int> e;
+    ASSERT_THROW(while (!r.done()) r.read_into(e, 100);, std::runtime_error);
+    // what arrived before the end stays
+    ASSERT_EQ(e.size(), 900);
+    std::istringstream wrong(s);
+    ASSERT_THROW(deque_checkpoint_reader<double> x(wrong), std::runtime_error);
+}
+
+TEST(TestDequeSerialize, reader_3) {
+    my_deque<int> d(5, 1);
+    std::ostringstream out;
+    d.serialize(out);
+    // a corrupt header claiming 2^40 elements
+    std::string s = out.str();
+    std::uint64_t count = std::uint64_t(1) << 40;
+    s.replace(16, sizeof(count), reinterpret_cast<const char*>(&count), sizeof(count));
+    std::istringstream in(s);
+    deque_checkpoint_reader<int> r(in);
+    ASSERT_EQ(r.remaining(), count);
+    my_deque<int> e;
+    ASSERT_THROW(r.read_into(e, std::size_t(count)), std::runtime_error);
+    ASSERT_EQ(e == d, true);
+}
+
+TEST(TestDequeSerialize, write_1) {
+    my_deque<int, std::allocator<int>, 4> d;
+    for (int i = 0; i < 5000; ++i)
+        d.push_front(i);
+    char name[] = "/tmp/TestDequeSerializeXXXXXX";
+    int fd = mkstemp(name);
+    ASSERT_EQ(fd >= 0, true);
+    deque_write(fd, d);
+    close(fd);
+    std::ifstream in(name, std::ios::binary);
+    my_deque<int, std::allocator<int>, 4> e;
+    e.deserialize(in);
+    std::remove(name);
+    ASSERT_EQ(e == d, true);
+    ASSERT_THROW(deque_write(-1, d), std::system_error);
+}
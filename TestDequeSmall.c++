@@ -0,0 +1,130 @@
+// // ---------------------------------
+// // projects/deque/TestDequeSmall.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // ---------------------------------
+
+// /*
+// To compile the test:
+//     % g++ -pedantic -std=c++11 -Wall TestDequeSmall.c++ -o TestDequeSmall -lgtest -lgtest_main -lpthread
+
+// To run the test:
+//     % valgrind TestDequeSmall
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <algorithm>   // equal, sort
+#include <string>      // string
+#include <type_traits> // is_nothrow_default_constructible, is_nothrow_move_constructible
+#include <utility>     // move
+
+#include "gtest/gtest.h"
+
+#include "DequeSmall.h"
+#include "DequeCountingAllocator.h"
+
+typedef small_deque<int, 4, counting_allocator<int>, 4> deque_type;
+
+TEST(TestDequeSmall, inline_1) {
+    static_assert(std::is_nothrow_default_constructible<deque_type>::value, "small_deque() must be noexcept");
+    static_assert(std::is_nothrow_move_constructible<deque_type>::value, "small_deque(small_deque&&) must be noexcept");
+    counting_allocator<int>::live  = 0;
+    counting_allocator<int*>::live = 0;
+    deque_type d;
+    for (int k = 0; k != 100; ++k) {
+        d.push_back(3);
+        d.push_front(2);
+        d.push_back(4);
+        d.push_front(1);
+        ASSERT_EQ(d.size(), 4);
+        ASSERT_EQ(d.front(), 1);
+        ASSERT_EQ(d.back(), 4);
+        ASSERT_EQ(d[2], 3);
+        d.pop_front();
+        d.pop_back();
+        d.pop_back();
+        ASSERT_EQ(d.front(), 2);
+        d.pop_front();}
+    ASSERT_EQ(d.empty(), true);
+    ASSERT_EQ(d.spilled(), false);
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+    ASSERT_EQ(counting_allocator<int*>::live, 0);
+}
+
+TEST(TestDequeSmall, iterator_1) {
+    deque_type d;
+    d.push_back(3);
+    d.push_back(1);
+    d.push_front(4);
+    d.push_front(2);
+    std::sort(d.begin(), d.end());
+    const int a[] = {1, 2, 3, 4};
+    ASSERT_EQ(std::equal(d.begin(), d.end(), a), true);
+    deque_type::const_iterator b = d.begin();
+    ASSERT_EQ(b == d.begin(), true);
+    ASSERT_EQ(d.end() - b, 4);
+    ASSERT_EQ(b[3], 4);
+    // an iterator is an index, so it survives the spill
+    deque_type::iterator i = d.begin() + 1;
+    d.push_back(5);
+    ASSERT_EQ(d.spilled(), true);
+    ASSERT_EQ(*i, 2);
+    ASSERT_EQ(d.end() - i, 4);
+}
+
+TEST(TestDequeSmall, spill_1) {
+    counting_allocator<int>::live = 0;
+    {
+    deque_type d;
+    for (int i = 0; i != 4; ++i)
+        d.push_front(i);
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+    // the new element refers to an inline one
+    d.push_back(d.front());
+    ASSERT_EQ(d.spilled(), true);
+    ASSERT_NE(counting_allocator<int>::live, 0);
+    const int a[] = {3, 2, 1, 0, 3};
+    ASSERT_EQ(std::equal(d.begin(), d.end(), a), true);
+    for (int i = 0; i != 100; ++i)
+        d.push_front(i);
+    ASSERT_EQ(d.size(), 105);
+    ASSERT_EQ(d.at(0), 99);
+    d.clear();
+    ASSERT_EQ(d.spilled(), true);
+    d.push_back(7);
+    d.shrink_to_fit();
+    ASSERT_EQ(d.spilled(), false);
+    ASSERT_EQ(d.front(), 7);
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+    }
+    ASSERT_EQ(counting_allocator<int>::live, 0);
+}
+
+TEST(TestDequeSmall, copy_1) {
+    small_deque<std::string, 2> x;
+    x.push_back("b");
+    x.push_front("a");
+    small_deque<std::string, 2> y(x);
+    ASSERT_EQ(x == y, true);
+    y.push_back("c");
+    ASSERT_EQ(y.spilled(), true);
+    ASSERT_EQ(x < y, true);
+    x = y;
+    ASSERT_EQ(x == y, true);
+    small_deque<std::string, 2> z(std::move(y));
+    ASSERT_EQ(z.size(), 3);
+    ASSERT_EQ(y.empty(), true);
+    ASSERT_EQ(y.spilled(), false);
+    y.push_back("d");
+    swap(y, z);
+    ASSERT_EQ(y.size(), 3);
+    ASSERT_EQ(y.back(), "c");
+    ASSERT_EQ(z.size(), 1);
+    ASSERT_EQ(z.front(), "d");
+    z = std::move(y);
+    ASSERT_EQ(z.size(), 3);
+    ASSERT_EQ(z[1], "b");
+}
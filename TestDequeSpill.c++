@@ -0,0 +1,125 @@
+// // ---------------------------------
+// // projects/deque/TestDequeSpill.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // ---------------------------------
+
+// /*
+// To compile the test:
+//     % g++ -pedantic -std=c++11 -Wall TestDequeSpill.c++ -o TestDequeSpill -lgtest -lgtest_main -lpthread
+
+// To run the test:
+//     % valgrind TestDequeSpill
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <cstddef>      // size_t
+#include <iterator>     // back_inserter
+#include <string>       // string
+#include <system_error> // system_error
+#include <type_traits>  // is_convertible
+#include <vector>       // vector
+
+#include "gtest/gtest.h"
+
+#include "DequeSpill.h"
+
+TEST(TestDequeSpill, file_1) {
+    deque_spill_file f(0, 1 << 16);
+    ASSERT_EQ(f.file_bytes(), 0);
+    char* p = static_cast<char*>(f.allocate(100));
+    ASSERT_EQ(f.file_bytes(), 1 << 16);
+    for (int i = 0; i < 100; ++i)
+        p[i] = char(i);
+    char* q = static_cast<char*>(f.allocate(1 << 20));
+    ASSERT_EQ(f.file_bytes(), (1 << 16) + (1 << 20));
+    for (int i = 0; i < (1 << 20); ++i)
+        q[i] = char(i % 7);
+    // the data survives being dropped from memory
+    f.spill(q, 1 << 20);
+    for (int i = 0; i < (1 << 20); i += 4093)
+        ASSERT_EQ(q[i], char(i % 7));
+    f.deallocate(p, 100);
+    ASSERT_EQ(f.allocate(128), p);
+}
+
+TEST(TestDequeSpill, file_2) {
+    ASSERT_THROW(deque_spill_file("/no/such/directory"), std::system_error);
+}
+
+TEST(TestDequeSpill, spill_1) {
+    deque_spill_file f(0, 1 << 16);
+    spill_deque<int, 1024> d(f, 4);
+    ASSERT_EQ(d.resident_blocks(), 4);
+    for (int i = 0; i < 100000; ++i)
+        d.push_back(i);
+    for (int i = 0; i < 100000; ++i)
+        d.push_front(-i);
+    ASSERT_EQ(d.size(), 200000);
+    for (int i = 0; i < 100000; i += 997) {
+        ASSERT_EQ(d.at(100000 + i), i);
+        ASSERT_EQ(d.at(99999 - i), -i);}
+    for (int i = 0; i < 50000; ++i) {
+        ASSERT_EQ(d.front(), -99999 + i);
+        d.pop_front();
+        ASSERT_EQ(d.back(), 99999 - i);
+        d.pop_back();}
+    ASSERT_EQ(d.size(), 100000);
+}
+
+TEST(TestDequeSpill, spill_2) {
+    deque_spill_file f;
+    spill_deque<std::string, 16> d(f, 2);
+    for (int i = 0; i < 1000; ++i)
+        d.push_back(std::string(30, char('a' + i % 26)));
+    spill_deque<std::string, 16> e(d);
+    ASSERT_EQ(e.get_allocator().file, &f);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(e.front(), std::string(30, char('a' + i % 26)));
+        e.pop_front();}
+    ASSERT_EQ(d.back(), std::string(30, char('a' + 999 % 26)));
+}
+
+TEST(TestDequeSpill, spill_3) {
+    typedef spill_deque<int, 1024> deque_type;
+    // only the deque's own calls reach the blocks
+    ASSERT_EQ((std::is_convertible<deque_type*, deque_type::base_type*>::value), false);
+    deque_spill_file f(0, 1 << 16);
+    deque_type d(f, 4);
+    std::vector<int> v(100000);
+    for (int i = 0; i < 100000; ++i)
+        v[i] = i;
+    // a bulk load spills its middle, as pushing one at a time would
+    d.append(v.begin(), v.end());
+    std::size_t s = f.spilled_bytes();
+    // 98 blocks, 3 hot ones at each end
+    ASSERT_GE(s, (98 - 2 * 3 - 1) * 1024 * sizeof(int));
+    d.resize(200000, 7);
+    ASSERT_GT(f.spilled_bytes(), s);
+    s = f.spilled_bytes();
+    d.prepend(v.begin(), v.end());
+    ASSERT_GT(f.spilled_bytes(), s);
+    ASSERT_EQ(d.size(), 300000);
+    ASSERT_EQ(d[99999], 99999);
+    ASSERT_EQ(d[100000], 0);
+    ASSERT_EQ(d[250000], 7);
+    d.insert(d.begin() + 1000, v.begin(), v.begin() + 10);
+    d.erase(d.begin() + 1000);
+    ASSERT_EQ(d[1000], 1);
+    ASSERT_EQ(d.pop_front_n(1009), 1009);
+    ASSERT_EQ(d.front(), 1000);
+    std::vector<int> w;
+    d.drain_front(10, std::back_inserter(w));
+    ASSERT_EQ(w.back(), 1009);
+    ASSERT_EQ(d.pop_back_n(100000), 100000);
+    ASSERT_EQ(d.back(), 99999);
+    deque_type e(d);
+    ASSERT_EQ(e == d, true);
+    e.clear();
+    ASSERT_EQ(e < d, true);
+    swap(d, e);
+    ASSERT_EQ(d.empty(), true);
+}
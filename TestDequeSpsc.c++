@@ -0,0 +1,90 @@
+// // --------------------------------
+// // projects/deque/TestDequeSpsc.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // --------------------------------
+
+// /*
+// To compile the test:
+//     % g++ -pedantic -std=c++11 -Wall TestDequeSpsc.c++ -o TestDequeSpsc -lgtest -lgtest_main -lpthread
+
+// To run the test:
+//     % valgrind TestDequeSpsc
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <cstddef> // size_t
+#include <string>  // string, to_string
+#include <thread>  // thread, yield
+
+#include "gtest/gtest.h"
+
+#include "DequeSpsc.h"
+
+TEST(TestDequeSpsc, push_1) {
+    spsc_block_queue<int, std::allocator<int>, 4> q;
+    int x = -1;
+    ASSERT_TRUE(q.empty());
+    ASSERT_FALSE(q.try_pop(x));
+    for (int i = 0; i < 10; ++i)
+        q.push(i);
+    ASSERT_EQ(q.size_approx(), 10);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(q.try_pop(x));
+        ASSERT_EQ(x, i);}
+    ASSERT_TRUE(q.empty());
+    ASSERT_FALSE(q.try_pop(x));
+    ASSERT_EQ(x, 9);
+}
+
+TEST(TestDequeSpsc, push_2) {
+    // blocks cycle through the chain without leaking the strings left behind
+    spsc_block_queue<std::string, std::allocator<std::string>, 3> q;
+    std::string s;
+    for (int r = 0; r < 100; ++r) {
+        for (int i = 0; i < 5; ++i)
+            q.emplace(20, char('a' + i));
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(q.try_pop(s));
+            ASSERT_EQ(s, std::string(20, char('a' + i)));}
+        ASSERT_TRUE(q.try_pop(s));}
+    q.push(std::string("left behind, a long enough string to allocate"));
+    q.push(std::string("and another one that the destructor frees"));
+}
+
+TEST(TestDequeSpsc, stress_1) {
+    const int n = 1000000;
+    spsc_block_queue<int, std::allocator<int>, 16> q;
+    std::thread producer([&q, n] {
+        for (int i = 0; i < n; ++i)
+            q.push(i);});
+    int expected = 0;
+    int x;
+    while (expected != n) {
+        if (q.try_pop(x)) {
+            ASSERT_EQ(x, expected);
+            ++expected;}
+        else
+            std::this_thread::yield();}
+    producer.join();
+    ASSERT_TRUE(q.empty());
+}
+
+TEST(TestDequeSpsc, stress_2) {
+    const int n = 100000;
+    spsc_block_queue<std::string, std::allocator<std::string>, 5> q;
+    std::thread producer([&q, n] {
+        for (int i = 0; i < n; ++i)
+            q.push(std::to_string(i) + " is a string too long for the small buffer");});
+    std::string s;
+    for (int i = 0; i < n;) {
+        if (q.try_pop(s)) {
+            ASSERT_EQ(s, std::to_string(i) + " is a string too long for the small buffer");
+            ++i;}
+        else
+            std::this_thread::yield();}
+    producer.join();
+}
@@ -0,0 +1,107 @@
+// // ---------------------------------
+// // projects/deque/TestDequeStats.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // ---------------------------------
+
+// /*
+// To compile the test:
+//     % g++ -pedantic -std=c++11 -Wall TestDequeStats.c++ -o TestDequeStats -lgtest -lgtest_main -lpthread
+
+// To run the test:
+//     % valgrind TestDequeStats
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <memory> // allocator
+
+#include "gtest/gtest.h"
+
+#include "Deque.h"
+
+typedef my_deque<int, std::allocator<int>, 4, deque_counting_stats> stats_deque;
+
+TEST(TestDequeStats, blocks_1) {
+    stats_deque d;
+    ASSERT_EQ(d.stats().block_allocations, 0);
+    d.push_back(0);
+    ASSERT_EQ(d.stats().block_allocations, 2);
+    d.pop_back();
+    ASSERT_EQ(d.stats().block_deallocations, 0);
+    for (int i = 0; i != 100; ++i)
+        d.push_back(i);
+    ASSERT_EQ(d.stats().block_allocations, 27);
+    d.clear();
+    // the block _e points into and the spares of each end, the back's drained at the front and moved there
+    ASSERT_EQ(d.stats().block_allocations - d.stats().block_deallocations, 1 + 2 * d.spare_blocks());
+    d.shrink_to_fit();
+    ASSERT_EQ(d.stats().block_allocations, d.stats().block_deallocations);
+}
+
+TEST(TestDequeStats, map_1) {
+    stats_deque d;
+    ASSERT_EQ(d.stats().map_reallocations, 0);
+    for (int i = 0; i != 100; ++i)
+        d.push_front(i);
+    ASSERT_NE(d.stats().map_reallocations, 0);
+    ASSERT_EQ(d.stats().map_bytes_copied % sizeof(int*), 0);
+    d.reset_stats();
+    ASSERT_EQ(d.stats().map_reallocations, 0);
+    ASSERT_EQ(d.stats().map_bytes_copied, 0);
+    ASSERT_EQ(d.stats().peak_size, 100);
+    ASSERT_GE(d.stats().peak_capacity, 100);
+}
+
+TEST(TestDequeStats, shifted_1) {
+    stats_deque d;
+    for (int i = 0; i != 10; ++i)
+        d.push_back(i);
+    d.insert(d.begin() + 2, -1);
+    ASSERT_EQ(d.stats().elements_shifted, 2);
+    d.insert(d.begin() + 8, -1);
+    ASSERT_EQ(d.stats().elements_shifted, 2 + 3);
+    d.erase(d.begin() + 9);
+    ASSERT_EQ(d.stats().elements_shifted, 2 + 3 + 2);
+    const int a[] = {7, 8, 9};
+    d.insert(d.begin() + 1, a, a + 3);
+    ASSERT_EQ(d.stats().elements_shifted, 2 + 3 + 2 + 1);
+    d.push_back(0);
+    d.push_front(0);
+    d.erase(d.begin());
+    ASSERT_EQ(d.stats().elements_shifted, 2 + 3 + 2 + 1);
+}
+
+TEST(TestDequeStats, peak_1) {
+    stats_deque d;
+    for (int i = 0; i != 100; ++i)
+        d.push_back(i);
+    while (!d.empty())
+        d.pop_front();
+    ASSERT_EQ(d.stats().peak_size, 100);
+    ASSERT_EQ(d.stats().peak_capacity % 4, 0);
+    ASSERT_GE(d.stats().peak_capacity, 100);
+    stats_deque e(1000, 1);
+    d.swap(e);
+    ASSERT_EQ(d.stats().peak_size, 1000);
+    ASSERT_GE(d.stats().peak_capacity, 1000);
+}
+
+TEST(TestDequeStats, fifo_1) {
+    stats_deque d;
+    for (int i = 0; i != 1000; ++i)
+        d.push_back(i);
+    for (int i = 0; i != 1000; ++i) {
+        d.push_back(i);
+        d.pop_front();}
+    d.reset_stats();
+    for (int i = 0; i != 100000; ++i) {
+        d.push_back(i);
+        d.pop_front();}
+    ASSERT_EQ(d.stats().block_allocations, 0);
+    ASSERT_EQ(d.stats().block_deallocations, 0);
+    ASSERT_EQ(d.stats().map_reallocations, 0);
+    ASSERT_EQ(d.stats().peak_size, 1001);
+}
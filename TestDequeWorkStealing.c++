@@ -0,0 +1,99 @@
+// // ----------------------------------------
+// // projects/deque/TestDequeWorkStealing.c++
+// // Copyright (C) 2014
+// // Glenn P. Downing
+// // ----------------------------------------
+
+// /*
+// To compile the test:
+//     % g++ -pedantic -std=c++11 -Wall TestDequeWorkStealing.c++ -o TestDequeWorkStealing -lgtest -lgtest_main -lpthread
+
+// To run the test:
+//     % valgrind TestDequeWorkStealing
+// */
+
+// // --------
+// // includes
+// // --------
+
+#include <atomic>  // atomic
+#include <cstddef> // size_t
+#include <thread>  // thread, yield
+#include <vector>  // vector
+
+#include "gtest/gtest.h"
+
+#include "DequeWorkStealing.h"
+
+TEST(TestDequeWorkStealing, push_1) {
+    work_stealing_deque<int> d(4);
+    int x = -1;
+    ASSERT_EQ(d.capacity(), 4);
+    ASSERT_TRUE(d.empty());
+    ASSERT_FALSE(d.pop_back(x));
+    ASSERT_FALSE(d.steal(x));
+    for (int i = 0; i < 10; ++i)
+        d.push_back(i);
+    ASSERT_EQ(d.capacity(), 16);
+    ASSERT_EQ(d.size_approx(), 10);
+    ASSERT_TRUE(d.steal(x));
+    ASSERT_EQ(x, 0);
+    ASSERT_TRUE(d.pop_back(x));
+    ASSERT_EQ(x, 9);
+    ASSERT_TRUE(d.steal(x));
+    ASSERT_EQ(x, 1);
+    for (int i = 8; i >= 2; --i) {
+        ASSERT_TRUE(d.pop_back(x));
+        ASSERT_EQ(x, i);}
+    ASSERT_FALSE(d.pop_back(x));
+    ASSERT_FALSE(d.steal(x));
+    ASSERT_EQ(x, 2);
+}
+
+TEST(TestDequeWorkStealing, push_2) {
+    // the ring wraps many times without growing
+    work_stealing_deque<long> d(8);
+    long x;
+    for (long i = 0; i < 1000; ++i) {
+        d.push_back(i);
+        d.push_back(-i);
+        ASSERT_TRUE(d.steal(x));
+        ASSERT_EQ(x, i);
+        ASSERT_TRUE(d.pop_back(x));
+        ASSERT_EQ(x, -i);}
+    ASSERT_EQ(d.capacity(), 8);
+    ASSERT_TRUE(d.empty());
+}
+
+TEST(TestDequeWorkStealing, stress_1) {
+    // the owner pushes and pops while three thieves steal, every item must be taken exactly once
+    const int n = 200000;
+    work_stealing_deque<int> d(2);
+    std::vector<std::atomic<int> > taken(n);
+    for (int i = 0; i < n; ++i)
+        taken[i].store(0);
+    std::atomic<bool> done(false);
+    std::vector<std::thread> thieves;
+    for (int k = 0; k < 3; ++k)
+        thieves.push_back(std::thread([&] {
+            int x;
+            while (!done.load())
+                if (d.steal(x))
+                    ++taken[x];
+                else
+                    std::this_thread::yield();}));
+    int x;
+    for (int i = 0; i < n; ++i) {
+        d.push_back(i);
+        if ((i % 3 == 0) && d.pop_back(x))
+            ++taken[x];}
+    while (d.pop_back(x))
+        ++taken[x];
+    while (!d.empty())
+        std::this_thread::yield();
+    done.store(true);
+    for (std::size_t k = 0; k != thieves.size(); ++k)
+        thieves[k].join();
+    for (int i = 0; i < n; ++i)
+        ASSERT_EQ(taken[i].load(), 1);
+}